@@ -1,12 +1,26 @@
 #ifndef MORRIS_ALGORITHMS_MCTS_HPP_
 #define MORRIS_ALGORITHMS_MCTS_HPP_
 
+#include "../games/game_traits.hpp"
+#include "../utility/histogram.hpp"
+#include "../utility/random.hpp"
+#include "../utility/trace.hpp"
+#include "prior.hpp"
+#include "proof_number.hpp"
+#include "rollout_policy.hpp"
+#include "search_statistics.hpp"
+#include "time_manager.hpp"
+
 namespace algorithm {
 
-template<class StateType>
+template<class StateType, unsigned PlayerCount = 2>
 struct MonteCarloNode {
-    MonteCarloNode(StateType state)
-    : state(state), q(0), visits(0), parent(nullptr) {
+    // move index of the root, which is not reached by any move
+    static const unsigned kNoMove = std::numeric_limits<unsigned>::max();
+
+    MonteCarloNode(StateType state, unsigned move_index = kNoMove)
+    : state(state), q(0), visits(0), parent(nullptr), proven(false), proven_values{},
+      move_index(move_index), amaf_q(0), amaf_visits(0), prior(0) {
     }
 
     ~MonteCarloNode() {
@@ -15,17 +29,36 @@ struct MonteCarloNode {
         }
     }
 
-    void AddChild(StateType const & state) {
-        auto * node = new MonteCarloNode<StateType>(state);
+    void AddChild(StateType const & state, unsigned move_index) {
+        auto * node = new MonteCarloNode(state, move_index);
         node->parent = this;
         children.push_back(node);
     }
 
-    void UpdateStatistics(double value) {
-        visits += 1;
+    // deletes everything below the node, which keeps its own statistics and becomes a leaf again
+    // returns how many nodes went
+    unsigned long long RemoveChildren() {
+        unsigned long long removed = children.size();
+        for (auto * child : children) {
+            removed += child->RemoveChildren();
+            delete child;
+        }
+        std::vector<MonteCarloNode*>().swap(children);
+        return removed;
+    }
+
+    void UpdateStatistics(double value, unsigned count = 1) {
+        visits += count;
 
         // cumulative moving average (average of all value's so far)
-        q += (value - q) / visits;
+        // a batch of playouts counts as that many visits with their mean value
+        q += (value - q) * count / visits;
+    }
+
+    // all moves as first, the value of every playout in which the player played this node's move
+    void UpdateAmafStatistics(double value) {
+        amaf_visits += 1;
+        amaf_q += (value - amaf_q) / amaf_visits;
     }
 
     bool HasChildren() {
@@ -36,6 +69,11 @@ struct MonteCarloNode {
         return visits == 0 ? std::numeric_limits<double>::max() : c * std::sqrt(2.0 * std::log(parent->visits) / visits);
     }
 
+    // exploration of PUCT, moves the evaluator likes are tried first and often
+    double PriorExploration(double c) {
+        return c * prior * std::sqrt(std::max(1u, parent->visits)) / (1 + visits);
+    }
+
     void Print() {
         std::cout << "MCTS NODE: \n";
         std::cout << "Visits: " << visits << '\n';
@@ -48,13 +86,125 @@ struct MonteCarloNode {
     unsigned visits;
     MonteCarloNode * parent;
     std::vector<MonteCarloNode*> children;
+
+    // the solver knows the exact value of the node for every player
+    bool proven;
+    std::array<double, PlayerCount> proven_values;
+
+    // the game's MoveIndex of the move that lead to this node
+    unsigned move_index;
+    double amaf_q;
+    unsigned amaf_visits;
+
+    // probability the evaluator gave the move among its siblings
+    double prior;
 };
 
-template<class GameType, class StateType, unsigned PlayerCount>
+// how one move of the root did in a search
+template<class StateType>
+struct MoveAnalysis {
+    // the state the move leads to and the game's MoveIndex of the move
+    StateType state;
+    unsigned move_index;
+
+    // visits of all threads and the visit weighted mean value for the player to move
+    unsigned visits;
+    double value;
+
+    // move indices of the most visited line starting with this move
+    std::vector<unsigned> principal_variation;
+};
+
+template<class GameType, class StateType, unsigned PlayerCount, class RandomEngineType = utility::Xoshiro256PlusPlus, class RolloutPolicyType = UniformRollout<GameType>>
 class MonteCarloTreeSearch {
 public:
+    using Node = MonteCarloNode<StateType, PlayerCount>;
+    using MoveType = typename decltype(GameType::ListMoves(std::declval<StateType const &>()))::value_type;
+    static_assert(boardgame::CheckGame<GameType, StateType, MoveType>(), "MonteCarloTreeSearch needs a game");
+
+    using Analysis = std::vector<MoveAnalysis<StateType>>;
+
+    // memory a node of the trees takes, counting the pointer its parent keeps
+    static constexpr std::size_t kNodeBytes = sizeof(Node) + sizeof(Node*);
+
+    // gets the ranking of the root moves while searching, returning false stops the search
+    using AnalysisCallback = std::function<bool(Analysis const &)>;
+
+    // the values of an ongoing state for every player like the games' StateValue, and a prior
+    // for each of its moves given by their move indices, for example from network::MakeLeafEvaluator
+    using LeafEvaluator = std::function<std::array<double, PlayerCount>(StateType const &, std::vector<unsigned> const &, std::vector<double> &)>;
+
+    // called by every search thread with true before it first calls the evaluator and with false
+    // after its last call, for example from network::MakeEvaluatorAttach
+    using EvaluatorAttach = std::function<void(bool)>;
+
+    // a weight for each move of a state, for example from HeuristicPrior
+    using PriorFunction = std::function<void(StateType const &, std::vector<MoveType> const &, std::vector<double> &)>;
+
+    // everything a single search thread owns
+    struct SearchThread {
+        SearchThread(RandomEngineType random_engine, unsigned index) : random_engine(random_engine), index(index) {
+            move_indices.reserve(GameType::kMaxBranchingFactor);
+            priors.reserve(GameType::kMaxBranchingFactor);
+        }
+
+        RandomEngineType random_engine;
+        unsigned index;
+        utility::Histogram rollout_lengths;
+
+        // buffers reused by every batched simulation
+        std::vector<StateType> batch_states;
+        std::vector<std::array<double, PlayerCount>> batch_values;
+
+        // {player, move index} of the moves played by the last playout
+        std::vector<std::array<unsigned, 2>> trace;
+
+        // buffers reused by every leaf evaluation, big enough for any state
+        std::vector<unsigned> move_indices;
+        std::vector<double> priors;
+
+        // a move index was played by a player in this iteration when its stamp equals amaf_stamp
+        std::vector<std::uint32_t> amaf_stamps;
+        std::uint32_t amaf_stamp = 0;
+
+        // what this thread did, merged into the search statistics
+        unsigned long long iterations = 0;
+        unsigned long long nodes = 0;
+        unsigned max_depth = 0;
+
+        // nodes of the tree now and at most, and the ones pruned to stay within node_budget
+        unsigned long long live_nodes = 0;
+        unsigned long long peak_nodes = 0;
+        unsigned long long pruned_nodes = 0;
+        unsigned long long node_budget = 0;
+
+        std::array<double, 4> phase_seconds = {};
+        double seconds = 0.0;
+        StopReason stop_reason = StopReason::kNone;
+    };
+
+    // what the threads of one search share
+    struct SearchShared {
+        explicit SearchShared(unsigned thread_count) : root_children(thread_count) {
+        }
+
+        // all threads stop once one has proven the root, the analysis callback asked to or the time manager did
+        std::atomic<bool> solved { false };
+        std::atomic<bool> stopped { false };
+        std::atomic<bool> out_of_time { false };
+
+        // milliseconds the threads search at most, besides the time of the search
+        // both count from the start of the move, so the precheck before the threads is included
+        long long max_time = std::numeric_limits<long long>::max();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        // {visits, value} of the root children last published by every thread for the analysis
+        std::mutex mutex;
+        std::vector<std::vector<std::array<double, 2>>> root_children;
+    };
+
     MonteCarloTreeSearch(unsigned max_iterations = 100, long long max_time_in_milliseconds = std::numeric_limits<long long>::max(), double c = 1.0, unsigned thread_count = 0)
-    : max_iterations_(max_iterations), max_time_(max_time_in_milliseconds), c_(c) {
+    : max_iterations_(max_iterations), max_time_(max_time_in_milliseconds), c_(c), seed_(utility::RandomSeed()) {
         if (thread_count == 0) {
             unsigned concurrent_threads = std::thread::hardware_concurrency();
             thread_count_ = concurrent_threads == 0 ? 4 : concurrent_threads;
@@ -64,33 +214,208 @@ public:
         }
     }
 
+    // number of playouts run from each selected leaf (leaf parallelization)
+    // more than one playout uses the game's lockstep BatchSimulate
+    void SetLeafBatchSize(unsigned leaf_batch_size) {
+        leaf_batch_size_ = std::max(1u, leaf_batch_size);
+    }
+
+    // the policy that picks the moves of the single playouts
+    // batched playouts always play uniformly random moves
+    void SetRolloutPolicy(RolloutPolicyType const & rollout_policy) {
+        rollout_policy_ = rollout_policy;
+    }
+
+    // playouts longer than this many plies stop and use the game's Evaluate instead
+    void SetMaxRolloutLength(unsigned max_rollout_length) {
+        max_rollout_length_ = max_rollout_length;
+    }
+
+    // lengths in plies of the single playouts of the last search, from all threads
+    utility::Histogram const & RolloutLengths() const {
+        return rollout_lengths_;
+    }
+
+    // prove wins, losses and draws of terminal states and propagate them up the tree (MCTS-Solver)
+    // proven subtrees are not searched anymore and the search stops once the root is proven
+    void SetSolver(bool solver) {
+        solver_ = solver;
+    }
+
+    // blend the all moves as first value of a move into its value while it has few visits (RAVE)
+    // the weight of the amaf value is sqrt(k / (3 n + k)) for equivalence k and n visits, 0 turns it off
+    void SetRave(unsigned equivalence) {
+        rave_equivalence_ = equivalence;
+    }
+
+    // evaluate the leaves instead of playing them out and select with PUCT on the priors (AlphaZero)
+    // all threads call the evaluator at the same time, which lets it batch their leaves,
+    // and attach tells a shared evaluator how many of them can be waiting on it
+    void SetEvaluator(LeafEvaluator evaluator, double c_puct = 1.5, EvaluatorAttach attach = nullptr) {
+        evaluator_ = evaluator;
+        evaluator_attach_ = attach;
+        c_puct_ = c_puct;
+    }
+
+    // weigh the moves of every expanded node by the prior and select with PUCT on them
+    // the rollouts stay, and an evaluator gives the priors instead when both are set
+    void SetPrior(PriorFunction prior, double c_puct = 1.5) {
+        prior_ = prior;
+        c_puct_ = c_puct;
+    }
+
+    // the value an unvisited child is scored with instead of being tried before all visited ones
+    // with UCT it is the whole score and with PUCT it replaces the mean value, the prior still adds to it
+    // PUCT without one scores an unvisited child a bit below the visited ones, see FirstPlayUrgency
+    void SetFirstPlayUrgency(double first_play_urgency) {
+        first_play_urgency_ = first_play_urgency;
+    }
+
+    // keep only one of the root moves that lead to symmetric states, they have the same value
+    // only games with a CanonicalHash have symmetries, it is on by default
+    void SetSymmetryPruning(bool symmetry_pruning) {
+        symmetry_pruning_ = symmetry_pruning;
+    }
+
+    // keep the trees of a search within about this many bytes, shared evenly by the threads, 0 is unbounded
+    // once a tree is full its least visited subtrees are collapsed into leaves that keep their
+    // visits and values, and the search goes on growing the tree where it visits most
+    void SetMemoryLimit(std::size_t memory_limit_in_bytes) {
+        memory_limit_ = memory_limit_in_bytes;
+    }
+
+    // play on a game clock instead of the fixed time per move, see TimeManager
+    // it is told the time left and the increment before every move, for example by Simulation::SetClock
+    // the first thread checks its best move every few milliseconds, stops once it is settled or can
+    // no longer be caught, and a move with nothing to choose from is played right away
+    void SetClock(long long remaining_in_milliseconds, long long increment_in_milliseconds) {
+        time_manager_.SetClock(remaining_in_milliseconds, increment_in_milliseconds);
+    }
+
+    // before every search df-pn tries to prove a forced win for the player to move within max_nodes,
+    // which is then played right away, and the root moves it proves the opponent to win after
+    // within their share of max_nodes are left out, unless all of them are
+    void SetProofNumberPrecheck(unsigned long long max_nodes, std::size_t table_megabytes = 16) {
+        if (max_nodes == 0) proof_search_.reset();
+        else proof_search_.emplace(max_nodes, table_megabytes);
+    }
+
+    // make the searches reproducible, every Compute still gets its own seed from this one
+    void SetSeed(std::uint64_t seed) {
+        seed_ = seed;
+    }
+
+    // the search stops early once the token is set, from any thread
+    // a stopped search still returns the best move found so far
+    void SetStopToken(std::shared_ptr<std::atomic<bool>> stop_token) {
+        stop_token_ = stop_token;
+    }
+
+    // every interval milliseconds the first thread passes the top moves to the callback
+    // the visits of the other threads are the ones they published at their last interval
+    void SetAnalysisCallback(AnalysisCallback analysis_callback, long long interval_in_milliseconds = 250, unsigned top_count = 5) {
+        analysis_callback_ = analysis_callback;
+        analysis_interval_ = std::max(1ll, interval_in_milliseconds);
+        analysis_top_count_ = top_count;
+    }
+
+    // the root moves of the last search ranked by visits, at most top_count of them
+    Analysis LastAnalysis(unsigned top_count = std::numeric_limits<unsigned>::max()) const {
+        return Analysis(analysis_.begin(), analysis_.begin() + std::min<std::size_t>(top_count, analysis_.size()));
+    }
+
+    // what the last search did, from all threads
+    SearchStatistics const & Statistics() const {
+        return statistics_;
+    }
+
     StateType Compute(StateType const & state) {
+        MORRIS_TRACE_SCOPE("mcts compute");
+        auto start = std::chrono::steady_clock::now();
+
+        // every thread draws from its own stream of the same seed
+        std::uint64_t seed = utility::SplitMix64(seed_);
+
+        if (time_manager_.IsActive()) time_manager_.StartMove<GameType>(state);
+
+        losing_root_keys_.clear();
+        if (proof_search_ && Precheck(state, start)) {
+            StateType winning_state = GameType::ApplyMove(state, *proof_search_->WinningMove());
+            PlayProven(winning_state, GameType::MoveIndex(*proof_search_->WinningMove()), start);
+            return winning_state;
+        }
 
         // run multiple threads of mcts
-        std::vector<std::future<MonteCarloNode<StateType>*>> futures;
+        SearchShared shared(thread_count_);
+        shared.start = start;
+        if (time_manager_.IsActive()) shared.max_time = time_manager_.HardLimit();
+        std::vector<SearchThread> threads;
+        threads.reserve(thread_count_);
+        for (unsigned i = 0; i < thread_count_; ++i) {
+            threads.emplace_back(utility::MakeRandomEngine<RandomEngineType>(seed, i), i);
+        }
+
+        std::vector<std::future<Node*>> futures;
         futures.reserve(thread_count_);
         for (unsigned i = 0; i < thread_count_; ++i) {
-            auto seed = std::random_device{}();
-            futures.push_back(std::async(std::launch::async, [i, &state, seed, this]() -> MonteCarloNode<StateType>* {
-                return Compute(state, seed);
+            futures.push_back(std::async(std::launch::async, [i, &state, &threads, &shared, this]() -> Node* {
+                MORRIS_TRACE_THREAD_NAME("mcts thread " + std::to_string(i));
+                return Compute(state, threads[i], shared);
             }));
         }
 
         // wait for all threads to finish and get the root
-        std::vector<MonteCarloNode<StateType>*> roots;
+        std::vector<Node*> roots;
         roots.reserve(thread_count_);
-        for (unsigned i = 0; i < thread_count_; ++i) {
-            roots.push_back(futures[i].get());
+        rollout_lengths_.Clear();
+        {
+            MORRIS_TRACE_SCOPE("mcts join");
+            for (unsigned i = 0; i < thread_count_; ++i) {
+                roots.push_back(futures[i].get());
+                rollout_lengths_.Merge(threads[i].rollout_lengths);
+            }
         }
 
-        std::mt19937 random_engine(std::random_device{}());
+        // the merge of the trees lasts until the end of the search, the teardown included
+        MORRIS_TRACE_SCOPE("mcts merge");
+        CollectStatistics(threads, start);
+        analysis_ = Analyze(roots);
+
+        auto random_engine = utility::MakeRandomEngine<RandomEngineType>(seed, thread_count_);
+
+        // a child proven to win in any of the trees is played right away
+        // children proven to lose are only played when nothing else is left
+        std::vector<bool> proven_loss(roots[0]->children.size(), false);
+        if (solver_) {
+            unsigned player = static_cast<unsigned>(state.player);
+            bool all_lose = true;
+            for (unsigned child_index = 0; child_index < proven_loss.size(); ++child_index) {
+                for (auto * root : roots) {
+                    Node * child = root->children[child_index];
+                    if (!child->proven) continue;
+                    if (child->proven_values[player] >= kWinValue) {
+                        StateType winning_state = child->state;
+                        MORRIS_TRACE_SCOPE("mcts teardown");
+                        for (auto * root_to_delete : roots) {
+                            delete root_to_delete;
+                        }
+                        return winning_state;
+                    }
+                    if (child->proven_values[player] <= kLossValue) proven_loss[child_index] = true;
+                }
+                all_lose = all_lose && proven_loss[child_index];
+            }
+            if (all_lose) std::fill(proven_loss.begin(), proven_loss.end(), false);
+        }
 
         // add all the visits of the children from each root
         // pick the child that maximizes the visits
-        MonteCarloNode<StateType> * best_child = nullptr;
+        Node * best_child = nullptr;
         unsigned max_visits = 0;
         size_t children_count = roots[0]->children.size();
         for (unsigned child_index = 0; child_index < children_count; ++child_index) {
+            if (proven_loss[child_index]) continue;
+
             unsigned child_visits = 0;
             for (unsigned root_index = 0; root_index < roots.size(); ++root_index) {
                 child_visits += roots[root_index]->children[child_index]->visits;
@@ -98,27 +423,19 @@ public:
 
             // change the best child by a coin flip
             if (child_visits == max_visits) {
-                std::uniform_int_distribution<std::mt19937::result_type> coin_flip(0, 1);
-                if (coin_flip(random_engine) == 1) {
+                if (best_child == nullptr || utility::Bounded(random_engine, 2) == 1) {
                     best_child = roots[0]->children[child_index];
                 }
             } else if (child_visits > max_visits) {
                 max_visits = child_visits;
                 best_child = roots[0]->children[child_index];
             }
-
-            //roots[0]->children[child_index]->Print();
         }
 
-        //std::cout << roots[0]->q << '\n';
-        //for (unsigned i = 0; i < roots[0]->children.size(); ++i) {
-        //	std::cout << roots[0]->children[i]->q << '\n';
-        //}
-        //std::cin.get();
-
         StateType best_state = best_child->state;
 
         // clean up the memory
+        MORRIS_TRACE_SCOPE("mcts teardown");
         for (unsigned i = 0; i < roots.size(); ++i) {
             delete roots[i];
         }
@@ -126,26 +443,118 @@ public:
         return best_state;
     }
 
-    MonteCarloNode<StateType> * Compute(StateType const & state, std::mt19937_64::result_type seed) {
+    Node * Compute(StateType const & state, SearchThread & thread, SearchShared & shared) {
+        MORRIS_TRACE_SCOPE("mcts thread search");
 
-        std::mt19937_64 random_engine(seed);
+        if (rave_equivalence_ > 0) {
+            thread.amaf_stamps.assign(PlayerCount * GameType::kMoveIndexCount, 0);
+        }
 
-        auto * root = new MonteCarloNode<StateType>(state);
+        auto * root = new Node(state);
 
         // expand once so the selection does not select the root
         Expand(root);
+        if (evaluator_attach_) evaluator_attach_(true);
+        if (evaluator_) Evaluate(root, thread);
+        thread.nodes = 1 + root->children.size();
+        thread.live_nodes = thread.nodes;
+        thread.peak_nodes = thread.nodes;
 
+        // a limit too small for the root and its children still lets the tree grow a little
+        if (memory_limit_ > 0) {
+            thread.node_budget = std::max<unsigned long long>(memory_limit_ / kNodeBytes / thread_count_, 4 * thread.nodes);
+        }
+
+        // with a clock the only move is played without searching
+        long long max_time = std::min(max_time_, shared.max_time);
+        bool time_managed = time_manager_.IsActive() && thread.index == 0;
+        if (time_manager_.IsActive() && root->children.size() == 1) max_time = 0;
+
+        // duration counts from the start of the move, the rate of the iterations from the start of the thread
         auto start = std::chrono::high_resolution_clock::now();
-        long long duration = 0;
-        for (unsigned i = 0; (i < max_iterations_) && (duration < max_time_); ++i) {
+        long long elapsed_before = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - shared.start).count();
+        long long duration = elapsed_before;
+        long long next_analysis = duration + analysis_interval_;
+        long long next_time_check = duration + kTimeCheckInterval;
+        unsigned i = 0;
+        for (; (i < max_iterations_) && (duration < max_time); ++i) {
 
-            MonteCarloNode<StateType> * leaf = Select(root);
+            if (solver_ && (root->proven || shared.solved.load(std::memory_order_relaxed))) {
+                shared.solved.store(true, std::memory_order_relaxed);
+                thread.stop_reason = StopReason::kSolved;
+                break;
+            }
+            if (shared.stopped.load(std::memory_order_relaxed) || (stop_token_ && stop_token_->load(std::memory_order_relaxed))) {
+                thread.stop_reason = StopReason::kStopped;
+                break;
+            }
+            if (shared.out_of_time.load(std::memory_order_relaxed)) {
+                thread.stop_reason = StopReason::kTime;
+                break;
+            }
+            if (time_managed && duration >= next_time_check) {
+                next_time_check = duration + kTimeCheckInterval;
+                if (!ContinueOnClock(root, i, duration, duration - elapsed_before)) {
+                    shared.out_of_time.store(true, std::memory_order_relaxed);
+                    thread.stop_reason = StopReason::kTime;
+                    break;
+                }
+            }
+            if (analysis_callback_ && duration >= next_analysis) {
+                next_analysis = duration + analysis_interval_;
+                PublishAnalysis(root, thread, shared);
+            }
+
+            // reading the clock costs about as much as a small iteration,
+            // so the phases are only timed on every kPhaseSampleInterval-th iteration
+            bool timed = i % kPhaseSampleInterval == 0;
+            std::array<std::chrono::high_resolution_clock::time_point, 5> marks;
+            if (timed) marks[0] = std::chrono::high_resolution_clock::now();
+
+            unsigned depth = 0;
+            Node * leaf = Select(root, depth);
+            if (timed) marks[1] = std::chrono::high_resolution_clock::now();
+
+            std::size_t children_count = leaf->children.size();
             Expand(leaf);
-            std::array<double, PlayerCount> values = Simulate(leaf, random_engine);
-            Backup(leaf, values);
+            thread.nodes += leaf->children.size() - children_count;
+            thread.live_nodes += leaf->children.size() - children_count;
+            thread.peak_nodes = std::max(thread.peak_nodes, thread.live_nodes);
+            thread.max_depth = std::max(thread.max_depth, depth + (leaf->HasChildren() ? 1 : 0));
+            if (timed) marks[2] = std::chrono::high_resolution_clock::now();
+
+            thread.trace.clear();
+            std::array<double, PlayerCount> values =
+                evaluator_ ? Evaluate(leaf, thread) :
+                leaf_batch_size_ > 1 ? Simulate(leaf, thread.random_engine, thread.batch_states, thread.batch_values) :
+                Simulate(leaf, thread);
+            if (timed) marks[3] = std::chrono::high_resolution_clock::now();
+
+            Backup(leaf, values, evaluator_ ? 1 : leaf_batch_size_);
+            if (rave_equivalence_ > 0) BackupAmaf(leaf, values, thread);
 
             auto end = std::chrono::high_resolution_clock::now();
-            duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            duration = elapsed_before + std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+            if (timed) {
+                marks[4] = end;
+                for (unsigned phase = 0; phase < thread.phase_seconds.size(); ++phase) {
+                    thread.phase_seconds[phase] += kPhaseSampleInterval * std::chrono::duration<double>(marks[phase + 1] - marks[phase]).count();
+                }
+                MORRIS_TRACE_SPAN("select", marks[0], marks[1]);
+                MORRIS_TRACE_SPAN("expand", marks[1], marks[2]);
+                MORRIS_TRACE_SPAN("simulate", marks[2], marks[3]);
+                MORRIS_TRACE_SPAN("backup", marks[3], marks[4]);
+            }
+
+            if (thread.node_budget > 0 && thread.live_nodes > thread.node_budget) Prune(root, thread);
+        }
+
+        if (evaluator_attach_) evaluator_attach_(false);
+        thread.iterations = i;
+        thread.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        if (thread.stop_reason == StopReason::kNone) {
+            thread.stop_reason = i >= max_iterations_ ? StopReason::kIterations : StopReason::kTime;
         }
 
         return root;
@@ -153,65 +562,514 @@ public:
 private:
     // select the node that has never been visited
     // if all nodes have been visited then select using exploitation / exploration
-    MonteCarloNode<StateType> * Select(MonteCarloNode<StateType> * root) const {
-        MonteCarloNode<StateType> * node = root;
+    // proven children are skipped since their value is already known
+    Node * Select(Node * root, unsigned & depth) const {
+        Node * node = root;
+        depth = 0;
         while (node->HasChildren()) {
-            node = *std::max_element(node->children.begin(), node->children.end(), [this] (MonteCarloNode<StateType> * n1, MonteCarloNode<StateType> * n2) {
-                return n1->q + n1->Exploration(c_) < n2->q + n2->Exploration(c_);
-            });
+            Node * best = nullptr;
+            double best_score = 0.0;
+            double first_play_urgency = evaluator_ || prior_ ? FirstPlayUrgency(node) : 0.0;
+            for (auto * child : node->children) {
+                if (child->proven) continue;
+
+                double score = Score(child, first_play_urgency);
+                if (best == nullptr || score > best_score) {
+                    best = child;
+                    best_score = score;
+                }
+            }
+            if (best == nullptr) break;
+            node = best;
+            ++depth;
         }
         return node;
     }
 
+    // proves a win for the player to move, or else the root moves that lose
+    // half of the node budget goes to the win, the rest is shared by the root moves, and on a clock
+    // the precheck ends after a part of the soft limit of the move that started at start
+    bool Precheck(StateType const & state, std::chrono::steady_clock::time_point start) {
+        MORRIS_TRACE_SCOPE("mcts precheck");
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        if (time_manager_.IsActive()) deadline = start + std::chrono::milliseconds(time_manager_.SoftLimit() / kPrecheckTimeShare);
+
+        unsigned long long max_nodes = proof_search_->MaxNodes();
+        if (proof_search_->Prove(state, max_nodes / 2, deadline) == ProofResult::kWin && proof_search_->WinningMove()) return true;
+
+        auto moves = GameType::ListMoves(state);
+        if (symmetry_pruning_) RemoveSymmetricMoves(state, moves);
+        if (moves.empty()) return false;
+
+        unsigned long long share = (max_nodes - std::min(max_nodes, proof_search_->Statistics().nodes)) / moves.size();
+        for (auto const & move : moves) {
+            if (share == 0 || std::chrono::steady_clock::now() >= deadline) break;
+            StateType next_state = GameType::ApplyMove(state, move);
+            if (proof_search_->Prove(next_state, share, deadline) == ProofResult::kWin) losing_root_keys_.push_back(GameType::Hash(next_state));
+        }
+        if (losing_root_keys_.size() == moves.size()) losing_root_keys_.clear();
+        return false;
+    }
+
+    // the last search was a proven win, which has the whole analysis to itself
+    void PlayProven(StateType const & winning_state, unsigned move_index, std::chrono::steady_clock::time_point start) {
+        rollout_lengths_.Clear();
+        statistics_ = proof_search_->Statistics();
+        statistics_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        analysis_ = { MoveAnalysis<StateType> { winning_state, move_index, 0, kWinValue, { move_index } } };
+    }
+
+    // the value PUCT gives the unvisited children of node, unless it is set the mean value of the
+    // visited children for the player to move less a reduction that grows with the prior they cover,
+    // so an unvisited child is neither a sure loss nor tried before a good visited one (Leela Zero)
+    // while none is visited every child gets the same value and the priors alone decide
+    double FirstPlayUrgency(Node * node) const {
+        if (first_play_urgency_) return *first_play_urgency_;
+
+        double value = 0.0;
+        double visited_prior = 0.0;
+        unsigned visits = 0;
+        for (auto * child : node->children) {
+            if (child->visits == 0) continue;
+            value += child->q * child->visits;
+            visited_prior += child->prior;
+            visits += child->visits;
+        }
+        if (visits == 0) return 0.0;
+        return value / visits - kFirstPlayUrgencyReduction * std::sqrt(visited_prior);
+    }
+
+    // how much the selection wants to visit the child, an unvisited one has the first play urgency under PUCT
+    double Score(Node * child, double first_play_urgency) const {
+        if (evaluator_ || prior_) {
+            double value = child->visits == 0 ? first_play_urgency : Value(child);
+            return value + child->PriorExploration(c_puct_);
+        }
+        if (child->visits == 0 && first_play_urgency_) return *first_play_urgency_;
+        return Value(child) + child->Exploration(c_);
+    }
+
+    // asks the time manager whether the first thread's best move needs more time
+    // the search also ends once the second move could not catch up in the rest of the soft limit
+    // at the rate the iterations ran so far, which only counts the search_duration of the thread
+    bool ContinueOnClock(Node * root, unsigned iterations, long long duration, long long search_duration) {
+        Node * best = nullptr;
+        Node * second = nullptr;
+        for (auto * child : root->children) {
+            if (best == nullptr || child->visits > best->visits) {
+                second = best;
+                best = child;
+            } else if (second == nullptr || child->visits > second->visits) {
+                second = child;
+            }
+        }
+        if (!time_manager_.Continue(duration, best->move_index)) return false;
+
+        double remaining_iterations = static_cast<double>(iterations) * (time_manager_.SoftLimit() - duration) / std::max(1ll, search_duration);
+        return second == nullptr || best->visits - second->visits <= remaining_iterations;
+    }
+
+    // the ranked root moves of all the trees
+    Analysis Analyze(std::vector<Node*> const & roots) const {
+        Analysis analysis;
+        for (unsigned child_index = 0; child_index < roots[0]->children.size(); ++child_index) {
+            analysis.push_back(AnalyzeChild(roots, child_index));
+        }
+        Rank(analysis);
+        return analysis;
+    }
+
+    // a root move over all the trees
+    // the principal variation follows the tree that visited the move the most
+    static MoveAnalysis<StateType> AnalyzeChild(std::vector<Node*> const & roots, unsigned child_index) {
+        Node * deepest = nullptr;
+        unsigned visits = 0;
+        double value = 0.0;
+        for (auto * root : roots) {
+            Node * child = root->children[child_index];
+            visits += child->visits;
+            value += child->q * child->visits;
+            if (deepest == nullptr || child->visits > deepest->visits) deepest = child;
+        }
+
+        MoveAnalysis<StateType> move_analysis { deepest->state, deepest->move_index, visits, visits > 0 ? value / visits : 0.0, {} };
+        for (Node * node = deepest; node != nullptr; node = MostVisitedChild(node)) {
+            move_analysis.principal_variation.push_back(node->move_index);
+        }
+        return move_analysis;
+    }
+
+    static Node * MostVisitedChild(Node * node) {
+        Node * best = nullptr;
+        for (auto * child : node->children) {
+            if (child->visits > 0 && (best == nullptr || child->visits > best->visits)) best = child;
+        }
+        return best;
+    }
+
+    static void Rank(Analysis & analysis) {
+        std::stable_sort(analysis.begin(), analysis.end(), [](auto const & a, auto const & b) {
+            return a.visits > b.visits;
+        });
+    }
+
+    // every thread publishes its root children, the first thread also ranks them and calls back
+    // its own tree gives the states and principal variations, all threads add their visits
+    void PublishAnalysis(Node * root, SearchThread const & thread, SearchShared & shared) const {
+        std::vector<std::array<double, 2>> children;
+        children.reserve(root->children.size());
+        for (auto * child : root->children) {
+            children.push_back({ static_cast<double>(child->visits), child->q });
+        }
+
+        std::vector<std::vector<std::array<double, 2>>> published;
+        {
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            shared.root_children[thread.index] = std::move(children);
+            if (thread.index != 0) return;
+            published = shared.root_children;
+        }
+
+        Analysis analysis;
+        for (unsigned child_index = 0; child_index < root->children.size(); ++child_index) {
+            auto move_analysis = AnalyzeChild({ root }, child_index);
+
+            double visits = 0.0, value = 0.0;
+            for (auto const & thread_children : published) {
+                if (thread_children.size() != root->children.size()) continue;
+                visits += thread_children[child_index][0];
+                value += thread_children[child_index][0] * thread_children[child_index][1];
+            }
+            move_analysis.visits = static_cast<unsigned>(visits);
+            move_analysis.value = visits > 0.0 ? value / visits : 0.0;
+            analysis.push_back(std::move(move_analysis));
+        }
+        Rank(analysis);
+        analysis.erase(analysis.begin() + std::min<std::size_t>(analysis.size(), analysis_top_count_), analysis.end());
+
+        if (!analysis_callback_(analysis)) {
+            shared.stopped.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // merge what the threads did, the trees are all alive until the end so their peaks add up
+    void CollectStatistics(std::vector<SearchThread> const & threads, std::chrono::steady_clock::time_point start) {
+        statistics_ = SearchStatistics();
+        bool solved = false, stopped = false, timed_out = false;
+        for (auto const & thread : threads) {
+            statistics_.iterations += thread.iterations;
+            statistics_.nodes += thread.nodes;
+            statistics_.pruned_nodes += thread.pruned_nodes;
+            statistics_.peak_memory_bytes += thread.peak_nodes * kNodeBytes;
+            statistics_.max_depth = std::max(statistics_.max_depth, thread.max_depth);
+            statistics_.thread_iterations_per_second.push_back(thread.seconds > 0.0 ? thread.iterations / thread.seconds : 0.0);
+            statistics_.select_seconds += thread.phase_seconds[0];
+            statistics_.expand_seconds += thread.phase_seconds[1];
+            statistics_.simulate_seconds += thread.phase_seconds[2];
+            statistics_.backup_seconds += thread.phase_seconds[3];
+            solved = solved || thread.stop_reason == StopReason::kSolved;
+            stopped = stopped || thread.stop_reason == StopReason::kStopped;
+            timed_out = timed_out || thread.stop_reason == StopReason::kTime;
+        }
+        statistics_.average_rollout_length = rollout_lengths_.Mean();
+        statistics_.stop_reason =
+            solved ? StopReason::kSolved :
+            stopped ? StopReason::kStopped :
+            timed_out ? StopReason::kTime : StopReason::kIterations;
+        statistics_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // the mean value of a node blended with its all moves as first value
+    double Value(Node * node) const {
+        if (rave_equivalence_ == 0 || node->amaf_visits == 0) return node->q;
+
+        double beta = std::sqrt(rave_equivalence_ / (3.0 * node->visits + rave_equivalence_));
+        return (1.0 - beta) * node->q + beta * node->amaf_q;
+    }
+
+    // collapse the least visited subtrees until the tree is down to three quarters of its budget
+    // which leaves room for the next quarter of nodes before pruning again
+    // the root and its children always stay, the analysis and the final pick read them
+    void Prune(Node * root, SearchThread & thread) const {
+        MORRIS_TRACE_SCOPE("mcts prune");
+        unsigned long long target = thread.node_budget / 4 * 3;
+
+        // {node, depth} of the nodes with children below the root
+        std::vector<std::pair<Node*, unsigned>> inner;
+        std::vector<std::pair<Node*, unsigned>> stack;
+        for (auto * child : root->children) {
+            stack.push_back({ child, 1 });
+        }
+        while (!stack.empty()) {
+            auto [node, depth] = stack.back();
+            stack.pop_back();
+            if (!node->HasChildren()) continue;
+            inner.push_back({ node, depth });
+            for (auto * child : node->children) {
+                stack.push_back({ child, depth + 1 });
+            }
+        }
+
+        // a child has at most the visits of its parent, so among equal visits the deeper
+        // nodes go first and no node is collapsed after one of its ancestors
+        std::sort(inner.begin(), inner.end(), [](auto const & a, auto const & b) {
+            return a.first->visits != b.first->visits ? a.first->visits < b.first->visits : a.second > b.second;
+        });
+        for (auto const & entry : inner) {
+            if (thread.live_nodes <= target) break;
+            unsigned long long removed = entry.first->RemoveChildren();
+            thread.live_nodes -= removed;
+            thread.pruned_nodes += removed;
+        }
+    }
+
     // get all the next possible states and make a node for each one
     // assign those nodes as children
-    void Expand(MonteCarloNode<StateType> *node) const {
+    void Expand(Node *node) const {
+
+        if (node->HasChildren()) return;
 
         // check if game is over already
         std::tuple<bool, std::array<double, PlayerCount>> result = GameType::StateValue(node->state);
-        if (std::get<0>(result) == false) return;
+        if (std::get<0>(result) == false) {
+            if (solver_) {
+                node->proven = true;
+                node->proven_values = std::get<1>(result);
+            }
+            return;
+        }
 
         auto moves = GameType::ListMoves(node->state);
+        if (node->parent == nullptr && symmetry_pruning_) RemoveSymmetricMoves(node->state, moves);
+        if (node->parent == nullptr && !losing_root_keys_.empty()) RemoveLosingMoves(node->state, moves);
+        node->children.reserve(moves.size());
         for (auto & move : moves) {
-            node->AddChild(GameType::ApplyMove(node->state, move));
+            node->AddChild(GameType::ApplyMove(node->state, move), GameType::MoveIndex(move));
+        }
+
+        // the evaluator sets the priors once it evaluates the node
+        if (prior_ && !evaluator_) {
+            std::vector<double> priors;
+            prior_(node->state, moves, priors);
+            double sum = 0.0;
+            for (auto prior : priors) {
+                sum += prior;
+            }
+            for (std::size_t i = 0; i < node->children.size(); ++i) {
+                node->children[i]->prior = sum > 0.0 ? priors[i] / sum : 1.0 / priors.size();
+            }
         }
     }
 
-    // play a policy until we reach the final state of the game
+    // of the moves that lead to states with the same canonical form only the first stays
+    static void RemoveSymmetricMoves(StateType const & state, std::vector<MoveType> & moves) {
+        if constexpr (boardgame::game_traits::kHasSymmetries<GameType, StateType>) {
+            std::vector<std::uint64_t> seen;
+            seen.reserve(moves.size());
+            std::size_t kept = 0;
+            for (auto & move : moves) {
+                std::uint64_t hash = GameType::CanonicalHash(GameType::ApplyMove(state, move));
+                if (std::find(seen.begin(), seen.end(), hash) != seen.end()) continue;
+                seen.push_back(hash);
+                moves[kept++] = move;
+            }
+            moves.erase(moves.begin() + kept, moves.end());
+        }
+    }
+
+    // the root moves the precheck proved to lose
+    void RemoveLosingMoves(StateType const & state, std::vector<MoveType> & moves) const {
+        moves.erase(std::remove_if(moves.begin(), moves.end(), [&](MoveType const & move) {
+            std::uint64_t hash = GameType::Hash(GameType::ApplyMove(state, move));
+            return std::find(losing_root_keys_.begin(), losing_root_keys_.end(), hash) != losing_root_keys_.end();
+        }), moves.end());
+    }
+
+    // play a policy until we reach the final state of the game or the rollout length limit
     // return the value of the final state
-    std::array<double, PlayerCount> Simulate(MonteCarloNode<StateType> *leaf, std::mt19937_64 &random_engine) {
+    // the moves are traced when the amaf statistics need them
+    std::array<double, PlayerCount> Simulate(Node *leaf, SearchThread &thread) {
 
         StateType final_state = leaf->state;
         std::tuple<bool, std::array<double, PlayerCount>> result = GameType::StateValue(final_state);
 
         // while the game is on going
+        unsigned length = 0;
         while (std::get<0>(result)) {
-            final_state = GameType::SimulationPolicy(final_state, random_engine);
+            if (length == max_rollout_length_) {
+                thread.rollout_lengths.Add(length);
+                return GameType::Evaluate(final_state);
+            }
+
+            MoveType move = rollout_policy_(final_state, thread.random_engine);
+            if (rave_equivalence_ > 0) {
+                thread.trace.push_back({ static_cast<unsigned>(final_state.player), GameType::MoveIndex(move) });
+            }
+            final_state = GameType::ApplyMove(final_state, move);
             result = GameType::StateValue(final_state);
+            ++length;
         }
 
         // the value of final state
+        thread.rollout_lengths.Add(length);
         return std::get<1>(result);
     }
 
+    // the evaluator's value of the leaf, which also sets the priors of its children
+    std::array<double, PlayerCount> Evaluate(Node * leaf, SearchThread & thread) const {
+        std::tuple<bool, std::array<double, PlayerCount>> result = GameType::StateValue(leaf->state);
+        if (!std::get<0>(result)) return std::get<1>(result);
+
+        thread.move_indices.clear();
+        for (auto * child : leaf->children) {
+            thread.move_indices.push_back(child->move_index);
+        }
+        std::array<double, PlayerCount> values = evaluator_(leaf->state, thread.move_indices, thread.priors);
+        for (std::size_t i = 0; i < leaf->children.size(); ++i) {
+            leaf->children[i]->prior = thread.priors[i];
+        }
+        return values;
+    }
+
+    // play leaf_batch_size_ playouts from the leaf in lockstep
+    // return the mean value of all the final states
+    std::array<double, PlayerCount> Simulate(Node *leaf, RandomEngineType &random_engine,
+                                             std::vector<StateType> &batch_states, std::vector<std::array<double, PlayerCount>> &batch_values) {
+
+        batch_states.assign(leaf_batch_size_, leaf->state);
+        GameType::BatchSimulate(batch_states, random_engine(), batch_values);
+
+        std::array<double, PlayerCount> values{};
+        for (auto const & batch_value : batch_values) {
+            for (unsigned player = 0; player < PlayerCount; ++player) {
+                values[player] += batch_value[player];
+            }
+        }
+        for (auto & value : values) {
+            value /= batch_values.size();
+        }
+        return values;
+    }
+
+    // the parent is proven once a child wins for the player to move, or once all children are proven
+    // in which case the player to move takes the best of them
+    bool ProveFromChildren(Node * node) const {
+        unsigned player = static_cast<unsigned>(node->state.player);
+        Node * best = nullptr;
+        bool all_proven = true;
+        for (auto * child : node->children) {
+            if (!child->proven) {
+                all_proven = false;
+                continue;
+            }
+            if (child->proven_values[player] >= kWinValue) {
+                best = child;
+                all_proven = true;
+                break;
+            }
+            if (best == nullptr || child->proven_values[player] > best->proven_values[player]) {
+                best = child;
+            }
+        }
+        if (!all_proven || best == nullptr) return false;
+
+        node->proven = true;
+        node->proven_values = best->proven_values;
+        return true;
+    }
+
+    // walk up from the leaf collecting the moves played below each node
+    // every child whose move the player to move played later on gets the playout's value
+    void BackupAmaf(Node * leaf, std::array<double, PlayerCount> const & values, SearchThread & thread) const {
+        if (++thread.amaf_stamp == 0) {
+            std::fill(thread.amaf_stamps.begin(), thread.amaf_stamps.end(), 0);
+            thread.amaf_stamp = 1;
+        }
+
+        auto mark = [&thread](unsigned player, unsigned move_index) {
+            thread.amaf_stamps[player * GameType::kMoveIndexCount + move_index] = thread.amaf_stamp;
+        };
+
+        for (auto const & played : thread.trace) {
+            mark(played[0], played[1]);
+        }
+
+        for (Node * node = leaf; node != nullptr; node = node->parent) {
+            unsigned player = static_cast<unsigned>(node->state.player);
+            for (auto * child : node->children) {
+                if (thread.amaf_stamps[player * GameType::kMoveIndexCount + child->move_index] == thread.amaf_stamp) {
+                    child->UpdateAmafStatistics(values[player]);
+                }
+            }
+            if (node->parent != nullptr) {
+                mark(static_cast<unsigned>(node->parent->state.player), node->move_index);
+            }
+        }
+    }
+
     // set the value of the node that was simulated and all its parents
-    void Backup(MonteCarloNode<StateType> * node, std::array<double, PlayerCount> const & values) const {
+    void Backup(Node * node, std::array<double, PlayerCount> const & values, unsigned count = 1) const {
+
+        // carry proofs up as far as they go
+        if (solver_ && node->proven) {
+            for (Node * parent = node->parent; parent != nullptr && ProveFromChildren(parent); parent = parent->parent) continue;
+        }
 
         // update all node's statistic based on their parents player
         while (node->parent != nullptr) {
-            node->UpdateStatistics(values[static_cast<unsigned>(node->parent->state.player)]);
+            node->UpdateStatistics(values[static_cast<unsigned>(node->parent->state.player)], count);
             node = node->parent;
         }
 
         // update root's visit count
-        node->UpdateStatistics(values[static_cast<unsigned>(node->state.player)]);
+        node->UpdateStatistics(values[static_cast<unsigned>(node->state.player)], count);
     }
 
 private:
+    // values of a won and a lost game as returned by the games' StateValue
+    static constexpr double kWinValue = 1.0;
+    static constexpr double kLossValue = 0.0;
+
+    // the first play urgency without one set is this much below the value of the visited children
+    // once they cover all of the prior
+    static constexpr double kFirstPlayUrgencyReduction = 0.2;
+
+    // the phases of one in this many iterations are timed
+    static const unsigned kPhaseSampleInterval = 16;
+
+    // milliseconds between two checks of the time manager
+    static constexpr long long kTimeCheckInterval = 5;
+
+    // the precheck on a clock takes at most this part of the soft limit
+    static constexpr long long kPrecheckTimeShare = 4;
+
     unsigned max_iterations_;
     long long max_time_;
     double c_;
     unsigned thread_count_;
+    unsigned leaf_batch_size_ = 1;
+    bool solver_ = false;
+    bool symmetry_pruning_ = true;
+    std::size_t memory_limit_ = 0;
+    TimeManager time_manager_;
+    std::optional<ProofNumberSearch<GameType, StateType>> proof_search_;
+    std::vector<std::uint64_t> losing_root_keys_;
+    unsigned rave_equivalence_ = 0;
+    unsigned max_rollout_length_ = std::numeric_limits<unsigned>::max();
+    std::uint64_t seed_;
+    RolloutPolicyType rollout_policy_;
+    utility::Histogram rollout_lengths_;
+    SearchStatistics statistics_;
+    std::shared_ptr<std::atomic<bool>> stop_token_;
+    LeafEvaluator evaluator_;
+    EvaluatorAttach evaluator_attach_;
+    PriorFunction prior_;
+    double c_puct_ = 1.5;
+    std::optional<double> first_play_urgency_;
+    AnalysisCallback analysis_callback_;
+    long long analysis_interval_ = 250;
+    unsigned analysis_top_count_ = 5;
+    Analysis analysis_;
 };
 
 } // namespace algorithm
@@ -1,19 +1,96 @@
 #ifndef MORRIS_ALGORITHMS_MIN_MAX_HPP_
 #define MORRIS_ALGORITHMS_MIN_MAX_HPP_
 
+#include "../games/game_traits.hpp"
+#include "search_statistics.hpp"
+#include "time_manager.hpp"
+
 template<class GameType, class StateType, class MoveType>
 class MinMax {
+    static_assert(boardgame::CheckGame<GameType, StateType, MoveType>(), "MinMax needs a game");
 public:
     MinMax(unsigned max_depth = std::numeric_limits<unsigned>::max()) : max_depth_(max_depth) {
     }
 
     StateType Compute(StateType const & state) {
-        auto state_and_value = Compute(state, static_cast<unsigned>(state.player), -std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), 0);
-        return std::get<0>(state_and_value);
+        auto start = std::chrono::steady_clock::now();
+        statistics_ = algorithm::SearchStatistics();
+        memory_bytes_ = 0;
+
+        StateType best_state = time_manager_.IsActive() ? ComputeDeepening(state, start) : Search(state, max_depth_);
+
+        statistics_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return best_state;
+    }
+
+    // play on a game clock, see algorithm::TimeManager
+    // it is told the time left and the increment before every move, for example by Simulation::SetClock
+    // the search then goes one ply deeper at a time up to the max depth until the time manager stops it
+    void SetClock(long long remaining_in_milliseconds, long long increment_in_milliseconds) {
+        time_manager_.SetClock(remaining_in_milliseconds, increment_in_milliseconds);
+    }
+
+    // number of states visited by the last search
+    unsigned long long Nodes() const {
+        return statistics_.nodes;
+    }
+
+    // what the last search did, the tree search has no phases or rollouts
+    algorithm::SearchStatistics const & Statistics() const {
+        return statistics_;
     }
 
 private:
+    // one alpha beta search down to the depth
+    StateType Search(StateType const & state, unsigned max_depth) {
+        search_depth_ = max_depth;
+        statistics_.stop_reason = algorithm::StopReason::kComplete;
+        return std::get<0>(Compute(state, static_cast<unsigned>(state.player), -std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), 0));
+    }
+
+    // iterative deepening, the move of the deepest finished search is played
+    // the first depth always finishes, a deeper one is given up at the hard limit, and no new one
+    // starts after half the soft limit since it takes longer than all before it together
+    StateType ComputeDeepening(StateType const & state, std::chrono::steady_clock::time_point start) {
+        time_manager_.StartMove<GameType>(state);
+
+        std::vector<MoveType> moves = GameType::ListMoves(state);
+        if (moves.size() == 1) {
+            statistics_.stop_reason = algorithm::StopReason::kTime;
+            return GameType::ApplyMove(state, moves[0]);
+        }
+
+        StateType best_state = state;
+        for (unsigned depth = 1; ; ++depth) {
+            StateType depth_state = Search(state, depth);
+            if (aborted_) {
+                statistics_.stop_reason = algorithm::StopReason::kTime;
+                break;
+            }
+            best_state = depth_state;
+            if (statistics_.stop_reason == algorithm::StopReason::kComplete || depth >= max_depth_) break;
+
+            long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            if (!time_manager_.Continue(elapsed, best_move_) || elapsed * 2 >= time_manager_.SoftLimit()) {
+                statistics_.stop_reason = algorithm::StopReason::kTime;
+                break;
+            }
+            deadline_ = start + std::chrono::milliseconds(time_manager_.HardLimit());
+        }
+
+        deadline_.reset();
+        aborted_ = false;
+        return best_state;
+    }
+
     std::tuple<StateType, double> Compute(StateType const & state, unsigned maximizing_player, double alpha, double beta, unsigned depth) {
+        ++statistics_.nodes;
+        statistics_.max_depth = std::max(statistics_.max_depth, depth);
+
+        // reading the clock on every node would cost more than the node
+        if (deadline_ && (statistics_.nodes % kDeadlineCheckInterval) == 0 && std::chrono::steady_clock::now() >= *deadline_) {
+            aborted_ = true;
+        }
 
         std::tuple<bool, std::array<double, 2>> state_value = GameType::StateValue(state, depth);
         bool on_going = std::get<0>(state_value);
@@ -25,16 +102,26 @@ private:
         }
 
         // for early termination, return whatever the current state value is
-        if (depth >= max_depth_) {
+        // an aborted search only unwinds, its values are thrown away
+        if (aborted_) {
+            return { state, value };
+        }
+        if (depth >= search_depth_) {
+            statistics_.stop_reason = algorithm::StopReason::kDepth;
             return { state, value };
         }
 
         double best_value;
-        StateType best_state;
+        StateType best_state = state;
 
         // expand the game tree given all the next possible states
         std::vector<MoveType> moves = GameType::ListMoves(state);
 
+        // the states and move lists along the current line are all the memory the search holds
+        std::size_t frame_bytes = sizeof(StateType) + moves.capacity() * sizeof(MoveType);
+        memory_bytes_ += frame_bytes;
+        statistics_.peak_memory_bytes = std::max(statistics_.peak_memory_bytes, memory_bytes_);
+
         if (static_cast<unsigned>(state.player) == maximizing_player) {
             best_value = -std::numeric_limits<double>::max();
             for (auto & move : moves) {
@@ -43,6 +130,8 @@ private:
                 if (value > best_value) {
                     best_value = value;
                     best_state = next_state;
+                    // the root is the maximizing player's
+                    if (depth == 0) best_move_ = static_cast<std::uint64_t>(&move - moves.data());
                 }
                 alpha = std::max(alpha, best_value);
                 if (alpha >= beta) break;
@@ -61,10 +150,24 @@ private:
                 if (alpha >= beta) break;
             }
         }
+        memory_bytes_ -= frame_bytes;
         return { best_state, best_value };
     }
 
+    // nodes between two looks at the clock
+    static const unsigned long long kDeadlineCheckInterval = 4096;
+
     unsigned max_depth_;
+    algorithm::SearchStatistics statistics_;
+    std::size_t memory_bytes_ = 0;
+
+    // depth of the running search and the position of its best root move among the root moves
+    unsigned search_depth_ = 0;
+    std::uint64_t best_move_ = 0;
+
+    algorithm::TimeManager time_manager_;
+    std::optional<std::chrono::steady_clock::time_point> deadline_;
+    bool aborted_ = false;
 };
 
 #endif /* MORRIS_ALGORITHMS_MIN_MAX_HPP_ */
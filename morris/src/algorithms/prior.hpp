@@ -0,0 +1,31 @@
+#ifndef MORRIS_ALGORITHMS_PRIOR_HPP_
+#define MORRIS_ALGORITHMS_PRIOR_HPP_
+
+namespace algorithm {
+
+// gives the moves of a state the weights the search explores them by, see MonteCarloTreeSearch::SetPrior
+// a prior fills one weight per move, the search normalizes them
+
+// the same weight for every move
+struct UniformPrior {
+    template<class StateType, class MoveType>
+    void operator()(StateType const & /*state*/, std::vector<MoveType> const & moves, std::vector<double> & priors) const {
+        priors.assign(moves.size(), 1.0);
+    }
+};
+
+// the game's MovePrior, which prefers for example moves that win or block the opponent
+template<class GameType>
+struct HeuristicPrior {
+    template<class StateType, class MoveType>
+    void operator()(StateType const & state, std::vector<MoveType> const & moves, std::vector<double> & priors) const {
+        priors.resize(moves.size());
+        for (std::size_t i = 0; i < moves.size(); ++i) {
+            priors[i] = GameType::MovePrior(state, moves[i]);
+        }
+    }
+};
+
+} // namespace algorithm
+
+#endif /* MORRIS_ALGORITHMS_PRIOR_HPP_ */
@@ -0,0 +1,328 @@
+#ifndef MORRIS_ALGORITHMS_PROOF_NUMBER_HPP_
+#define MORRIS_ALGORITHMS_PROOF_NUMBER_HPP_
+
+#include "../games/game_traits.hpp"
+#include "search_statistics.hpp"
+
+namespace algorithm {
+
+// what a proof number search found out about the player to move
+enum class ProofResult {
+    kUnknown,
+    kWin,
+    kNoWin
+};
+
+// depth-first proof number search (df-pn) of whether the player to move can force a win
+// it always goes on below the state that is closest to settling the question, which lets
+// it prove sharp wins that are far too deep for MinMax and that MCTS only finds by luck
+//
+// the proof and disproof numbers of the searched states are kept in a transposition table of
+// a fixed size, and every Prove stops after its node budget
+// a proven win is exact, a disproof is not when it came from cutting a repetition of the
+// line being searched or from the depth limit
+template<class GameType, class StateType>
+class ProofNumberSearch {
+public:
+    using MoveType = typename decltype(GameType::ListMoves(std::declval<StateType const &>()))::value_type;
+    static_assert(boardgame::CheckGame<GameType, StateType, MoveType>(), "ProofNumberSearch needs a game");
+
+    // nodes one Compute or Prove searches at most and the memory of the table
+    ProofNumberSearch(unsigned long long max_nodes = 1000000, std::size_t table_megabytes = 64)
+    : max_nodes_(std::max(1ull, max_nodes)), table_megabytes_(table_megabytes) {
+    }
+
+    // proves whether the player to move can force a win within the node budget
+    ProofResult Prove(StateType const & state) {
+        return Prove(state, max_nodes_);
+    }
+
+    // the search also stops at the deadline, which is only looked at every kDeadlineCheckInterval nodes
+    ProofResult Prove(StateType const & state, unsigned long long max_nodes,
+                      std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+        auto start = std::chrono::steady_clock::now();
+        statistics_ = SearchStatistics();
+        deadline_ = deadline;
+        ProofResult result = Run(state, std::max(1ull, max_nodes));
+        deadline_ = std::chrono::steady_clock::time_point::max();
+        Finish(result, start);
+        return result;
+    }
+
+    // the move that wins after Prove returned kWin for an ongoing state
+    std::optional<MoveType> const & WinningMove() const {
+        return winning_move_;
+    }
+
+    // plays a proven win right away, otherwise spends the rest of the budget on proving what
+    // every move allows the opponent and plays the one the opponent is furthest from winning after
+    StateType Compute(StateType const & state) {
+        auto start = std::chrono::steady_clock::now();
+        statistics_ = SearchStatistics();
+
+        ProofResult result = Run(state, max_nodes_ / 2);
+        if (result == ProofResult::kWin && winning_move_) {
+            Finish(result, start);
+            return GameType::ApplyMove(state, *winning_move_);
+        }
+
+        std::vector<MoveType> moves = GameType::ListMoves(state);
+        if (moves.empty()) {
+            Finish(result, start);
+            return state;
+        }
+
+        unsigned long long share = std::max(1ull, (max_nodes_ - std::min(max_nodes_, statistics_.nodes)) / moves.size());
+        std::size_t best = 0;
+        std::uint64_t best_proof = 0;
+        bool all_lose = true;
+        for (std::size_t i = 0; i < moves.size(); ++i) {
+            bool loses = Run(GameType::ApplyMove(state, moves[i]), share) == ProofResult::kWin;
+            all_lose = all_lose && loses;
+            std::uint64_t proof = loses ? 0 : 1ull + last_proof_;
+            if (proof > best_proof) {
+                best = i;
+                best_proof = proof;
+            }
+        }
+
+        // the moves are settled once every one is proven to lose or one is proven not to
+        Finish(all_lose || best_proof > kInfinity ? ProofResult::kNoWin : ProofResult::kUnknown, start);
+        return GameType::ApplyMove(state, moves[best]);
+    }
+
+    unsigned long long MaxNodes() const {
+        return max_nodes_;
+    }
+
+    // what the last Compute or Prove did
+    SearchStatistics const & Statistics() const {
+        return statistics_;
+    }
+
+private:
+    // the table holds the numbers of the player to move at the root of the search winning
+    struct Numbers {
+        std::uint32_t proof;
+        std::uint32_t disproof;
+    };
+
+    struct Entry {
+        std::uint64_t key;
+        Numbers numbers;
+
+        // nodes searched below the state, the entries that took the least work are replaced first
+        std::uint64_t work;
+    };
+
+    struct Child {
+        StateType state;
+        std::uint64_t key;
+        Numbers numbers;
+
+        // a finished game keeps its numbers
+        bool exact;
+    };
+
+    static constexpr std::uint32_t kInfinity = std::numeric_limits<std::uint32_t>::max();
+    static constexpr Numbers kProven = { 0, kInfinity };
+    static constexpr Numbers kDisproven = { kInfinity, 0 };
+
+    // entries one key can be stored in
+    static const unsigned kBucketSize = 4;
+
+    // lines deeper than this count as no win, which also bounds the recursion
+    static const unsigned kMaxDepth = 256;
+
+    // nodes between two looks at the clock for the deadline
+    static const unsigned kDeadlineCheckInterval = 256;
+
+    // the states of a search for the other player's win have their own keys
+    static constexpr std::uint64_t kRightPlayerKey = 0x9E3779B97F4A7C15ull;
+
+    // sums of the numbers stay below infinity, which only proofs and disproofs reach
+    static std::uint32_t Add(std::uint32_t a, std::uint32_t b) {
+        if (a == kInfinity || b == kInfinity) return kInfinity;
+        return static_cast<std::uint32_t>(std::min<std::uint64_t>(static_cast<std::uint64_t>(a) + b, kInfinity - 1));
+    }
+
+    std::uint64_t Key(StateType const & state) const {
+        std::uint64_t hash = 0;
+        if constexpr (boardgame::game_traits::kHasSymmetries<GameType, StateType>) {
+            hash = GameType::CanonicalHash(state);
+        } else {
+            hash = GameType::Hash(state);
+        }
+        return target_ == boardgame::Player::kLeftPlayer ? hash : hash ^ kRightPlayerKey;
+    }
+
+    Entry * Bucket(std::uint64_t key) {
+        return table_.data() + (key & (table_.size() / kBucketSize - 1)) * kBucketSize;
+    }
+
+    bool Lookup(std::uint64_t key, Numbers & numbers) {
+        Entry * bucket = Bucket(key);
+        for (unsigned i = 0; i < kBucketSize; ++i) {
+            if (bucket[i].key == key && bucket[i].work > 0) {
+                numbers = bucket[i].numbers;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Store(std::uint64_t key, Numbers numbers, std::uint64_t work) {
+        Entry * bucket = Bucket(key);
+        Entry * replaced = bucket;
+        for (unsigned i = 0; i < kBucketSize; ++i) {
+            if (bucket[i].key == key) {
+                replaced = bucket + i;
+                break;
+            }
+            if (bucket[i].work < replaced->work) replaced = bucket + i;
+        }
+        *replaced = { key, numbers, std::max<std::uint64_t>(1, work) };
+    }
+
+    // the table is only allocated once a search needs it, so copies of an unused search are cheap
+    void AllocateTable() {
+        if (!table_.empty()) return;
+        std::size_t entries = kBucketSize;
+        while (entries * 2 * sizeof(Entry) <= (table_megabytes_ << 20)) entries *= 2;
+        table_.assign(entries, Entry { 0, { 0, 0 }, 0 });
+    }
+
+    // proves the player to move winning the state, adding to the statistics
+    ProofResult Run(StateType const & state, unsigned long long max_nodes) {
+        winning_move_.reset();
+        auto winner = GameType::Winner(state);
+        if (!std::get<0>(winner)) {
+            bool won = std::get<1>(winner) == state.player;
+            last_proof_ = won ? 0 : kInfinity;
+            return won ? ProofResult::kWin : ProofResult::kNoWin;
+        }
+
+        AllocateTable();
+        target_ = state.player;
+        node_limit_ = statistics_.nodes + max_nodes;
+        out_of_time_ = false;
+        path_.clear();
+
+        Numbers numbers = { 1, 1 };
+        Search(state, Key(state), kInfinity, kInfinity, 0, numbers);
+        last_proof_ = numbers.proof;
+        if (numbers.proof == 0) return ProofResult::kWin;
+        if (numbers.disproof == 0) return ProofResult::kNoWin;
+        return ProofResult::kUnknown;
+    }
+
+    void Finish(ProofResult result, std::chrono::steady_clock::time_point start) {
+        statistics_.stop_reason = result != ProofResult::kUnknown ? StopReason::kSolved : out_of_time_ ? StopReason::kTime : StopReason::kIterations;
+        statistics_.peak_memory_bytes = table_.size() * sizeof(Entry);
+        statistics_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // searches below the state until its numbers reach one of the thresholds or the budget is spent
+    // the player to search the win of picks the child closest to a proof, the other one the child
+    // closest to a disproof, and the child gets thresholds that send the search back up as soon as
+    // another child would be closer
+    void Search(StateType const & state, std::uint64_t key, std::uint32_t proof_threshold, std::uint32_t disproof_threshold,
+                unsigned depth, Numbers & numbers) {
+        ++statistics_.nodes;
+        if (statistics_.nodes % kDeadlineCheckInterval == 0 && deadline_ != std::chrono::steady_clock::time_point::max()) {
+            out_of_time_ = out_of_time_ || std::chrono::steady_clock::now() >= deadline_;
+        }
+        statistics_.max_depth = std::max(statistics_.max_depth, depth);
+        unsigned long long start_nodes = statistics_.nodes;
+        bool or_node = state.player == target_;
+
+        std::vector<MoveType> moves = GameType::ListMoves(state);
+        std::vector<Child> children;
+        children.reserve(moves.size());
+        for (auto const & move : moves) {
+            Child child { GameType::ApplyMove(state, move), 0, { 1, 1 }, false };
+            auto winner = GameType::Winner(child.state);
+            if (!std::get<0>(winner)) {
+                child.numbers = std::get<1>(winner) == target_ ? kProven : kDisproven;
+                child.exact = true;
+            } else if (depth + 1 >= kMaxDepth) {
+                child.numbers = kDisproven;
+                child.exact = true;
+            } else {
+                child.key = Key(child.state);
+            }
+            children.push_back(child);
+        }
+        if (children.empty()) {
+            numbers = kDisproven;
+            Store(key, numbers, 1);
+            return;
+        }
+
+        path_.push_back(key);
+        for (;;) {
+            std::size_t best = 0;
+            std::uint32_t second = kInfinity;
+            numbers = or_node ? Numbers { kInfinity, 0 } : Numbers { 0, kInfinity };
+            for (std::size_t i = 0; i < children.size(); ++i) {
+                Child & child = children[i];
+                if (!child.exact) {
+                    // going back to a state of the line would never end, so it is no win
+                    if (std::find(path_.begin(), path_.end(), child.key) != path_.end()) child.numbers = kDisproven;
+                    else Lookup(child.key, child.numbers);
+                }
+
+                std::uint32_t closeness = or_node ? child.numbers.proof : child.numbers.disproof;
+                std::uint32_t & smallest = or_node ? numbers.proof : numbers.disproof;
+                if (closeness < smallest) {
+                    second = smallest;
+                    smallest = closeness;
+                    best = i;
+                } else if (closeness < second) {
+                    second = closeness;
+                }
+                if (or_node) numbers.disproof = Add(numbers.disproof, child.numbers.disproof);
+                else numbers.proof = Add(numbers.proof, child.numbers.proof);
+            }
+            if (depth == 0 && numbers.proof == 0) winning_move_ = moves[best];
+
+            if (numbers.proof >= proof_threshold || numbers.disproof >= disproof_threshold || statistics_.nodes >= node_limit_ || out_of_time_) break;
+
+            Child & child = children[best];
+            std::uint64_t child_second = std::min<std::uint64_t>(static_cast<std::uint64_t>(second) + 1, kInfinity);
+            std::uint32_t child_proof_threshold, child_disproof_threshold;
+            if (or_node) {
+                child_proof_threshold = static_cast<std::uint32_t>(std::min<std::uint64_t>(proof_threshold, child_second));
+                child_disproof_threshold = static_cast<std::uint32_t>(
+                    std::min<std::uint64_t>(static_cast<std::uint64_t>(disproof_threshold) - numbers.disproof + child.numbers.disproof, kInfinity));
+            } else {
+                child_disproof_threshold = static_cast<std::uint32_t>(std::min<std::uint64_t>(disproof_threshold, child_second));
+                child_proof_threshold = static_cast<std::uint32_t>(
+                    std::min<std::uint64_t>(static_cast<std::uint64_t>(proof_threshold) - numbers.proof + child.numbers.proof, kInfinity));
+            }
+            Search(child.state, child.key, child_proof_threshold, child_disproof_threshold, depth + 1, child.numbers);
+        }
+        path_.pop_back();
+
+        Store(key, numbers, statistics_.nodes - start_nodes + 1);
+    }
+
+    unsigned long long max_nodes_;
+    std::size_t table_megabytes_;
+    std::vector<Entry> table_;
+
+    // the player whose win the running search proves, its line and where it has to stop
+    boardgame::Player target_ = boardgame::Player::kLeftPlayer;
+    std::vector<std::uint64_t> path_;
+    unsigned long long node_limit_ = 0;
+    std::chrono::steady_clock::time_point deadline_ = std::chrono::steady_clock::time_point::max();
+    bool out_of_time_ = false;
+
+    std::optional<MoveType> winning_move_;
+    std::uint32_t last_proof_ = 0;
+    SearchStatistics statistics_;
+};
+
+} // namespace algorithm
+
+#endif /* MORRIS_ALGORITHMS_PROOF_NUMBER_HPP_ */
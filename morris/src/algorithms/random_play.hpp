@@ -1,16 +1,25 @@
 #ifndef MORRIS_ALGORITHMS_RANDOM_PLAY_HPP_
 #define MORRIS_ALGORITHMS_RANDOM_PLAY_HPP_
 
+#include "../utility/random.hpp"
+
 namespace algorithm {
 
-template<class GameType, class StateType>
+template<class GameType, class StateType, class RandomEngineType = utility::Xoshiro256PlusPlus>
 class RandomPlay {
 public:
+    RandomPlay(std::uint64_t seed = utility::RandomSeed()) : random_engine_(utility::MakeRandomEngine<RandomEngineType>(seed, 0)) {
+    }
+
+    void SetSeed(std::uint64_t seed) {
+        random_engine_ = utility::MakeRandomEngine<RandomEngineType>(seed, 0);
+    }
+
     StateType Compute(StateType const & state) {
-        std::mt19937_64 random_engine;
-        return GameType::SimulationPolicy(state, random_engine);
+        return GameType::SimulationPolicy(state, random_engine_);
     }
 private:
+    RandomEngineType random_engine_;
 };
 
 } // namespace algorithm
@@ -0,0 +1,40 @@
+#ifndef MORRIS_ALGORITHMS_ROLLOUT_POLICY_HPP_
+#define MORRIS_ALGORITHMS_ROLLOUT_POLICY_HPP_
+
+#include "../utility/random.hpp"
+
+namespace algorithm {
+
+// picks the moves played during the simulation step of the search
+// a policy returns the next move for the given state
+
+// uniformly random moves
+template<class GameType>
+struct UniformRollout {
+    template<class StateType, class RandomEngineType>
+    auto operator()(StateType const & state, RandomEngineType & random_engine) const {
+        return GameType::RandomMove(state, random_engine);
+    }
+};
+
+// the game's informed HeavyMove, mixed with a fraction epsilon of uniformly random moves
+// so the playouts do not become deterministic
+template<class GameType>
+struct HeavyRollout {
+    HeavyRollout(double epsilon = 0.1) : epsilon(epsilon) {
+    }
+
+    template<class StateType, class RandomEngineType>
+    auto operator()(StateType const & state, RandomEngineType & random_engine) const {
+        if (epsilon > 0.0 && utility::UniformReal(random_engine) < epsilon) {
+            return GameType::RandomMove(state, random_engine);
+        }
+        return GameType::HeavyMove(state, random_engine);
+    }
+
+    double epsilon;
+};
+
+} // namespace algorithm
+
+#endif /* MORRIS_ALGORITHMS_ROLLOUT_POLICY_HPP_ */
@@ -0,0 +1,83 @@
+#ifndef MORRIS_ALGORITHMS_SEARCH_STATISTICS_HPP_
+#define MORRIS_ALGORITHMS_SEARCH_STATISTICS_HPP_
+
+namespace algorithm {
+
+// why the last search stopped
+enum class StopReason {
+    kNone,
+    kIterations,
+    kTime,
+    kSolved,
+    kDepth,
+    kComplete,
+    kStopped
+};
+
+inline std::string StopReasonName(StopReason stop_reason) {
+    switch (stop_reason) {
+        case StopReason::kIterations: return "iterations";
+        case StopReason::kTime: return "time";
+        case StopReason::kSolved: return "solved";
+        case StopReason::kDepth: return "depth";
+        case StopReason::kComplete: return "complete";
+        case StopReason::kStopped: return "stopped";
+        default: return "none";
+    }
+}
+
+// what the last Compute of a search did, filled by every algorithm that searches
+struct SearchStatistics {
+    // mcts iterations of all threads, zero for the tree searches
+    unsigned long long iterations = 0;
+
+    // nodes allocated by mcts or states visited by minmax
+    unsigned long long nodes = 0;
+
+    // nodes mcts deleted to stay within its memory limit
+    unsigned long long pruned_nodes = 0;
+
+    // deepest node below the root
+    unsigned max_depth = 0;
+
+    double average_rollout_length = 0.0;
+
+    // iterations per second of every mcts thread
+    std::vector<double> thread_iterations_per_second;
+
+    // time spent in each phase of mcts summed over the threads
+    double select_seconds = 0.0;
+    double expand_seconds = 0.0;
+    double simulate_seconds = 0.0;
+    double backup_seconds = 0.0;
+
+    // wall time of the whole search
+    double seconds = 0.0;
+
+    // estimate of the most memory the search held at once
+    std::size_t peak_memory_bytes = 0;
+
+    StopReason stop_reason = StopReason::kNone;
+
+    double NodesPerSecond() const {
+        return seconds > 0.0 ? nodes / seconds : 0.0;
+    }
+
+    void Print() const {
+        std::cout
+            << "iterations: " << iterations << '\n'
+            << "nodes: " << nodes << " (" << NodesPerSecond() << "/s)\n"
+            << "pruned nodes: " << pruned_nodes << '\n'
+            << "max depth: " << max_depth << '\n'
+            << "average rollout length: " << average_rollout_length << '\n'
+            << "phases: select " << select_seconds << "s, expand " << expand_seconds
+            << "s, simulate " << simulate_seconds << "s, backup " << backup_seconds << "s\n"
+            << "seconds: " << seconds << '\n'
+            << "peak memory: " << peak_memory_bytes << " bytes\n"
+            << "stop reason: " << StopReasonName(stop_reason) << '\n';
+    }
+};
+
+} // namespace algorithm
+
+#endif /* MORRIS_ALGORITHMS_SEARCH_STATISTICS_HPP_ */
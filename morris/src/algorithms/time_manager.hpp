@@ -0,0 +1,99 @@
+#ifndef MORRIS_ALGORITHMS_TIME_MANAGER_HPP_
+#define MORRIS_ALGORITHMS_TIME_MANAGER_HPP_
+
+#include "../games/game_traits.hpp"
+
+namespace algorithm {
+
+// spreads the time left on a game clock over the moves still to play
+// every move gets a soft limit the search stops at when its best move is settled, which grows
+// when the best move changes, and a hard limit it never goes over
+//
+// the search is told the clock with SetClock before every move and asks Continue while it runs
+class TimeManager {
+public:
+    // moves the clock is spread over for games that do not estimate it
+    static const unsigned kDefaultMovesToGo = 20;
+
+    // time kept back on every move for what happens around the search
+    static constexpr long long kOverhead = 10;
+
+    // the soft limit grows to at most this many times its start
+    static constexpr double kMaxExtension = 3.0;
+
+    // time left on the clock of the player to move and what the clock gains after the move
+    void SetClock(long long remaining_in_milliseconds, long long increment_in_milliseconds) {
+        remaining_ = remaining_in_milliseconds;
+        increment_ = increment_in_milliseconds;
+        active_ = true;
+    }
+
+    bool IsActive() const {
+        return active_;
+    }
+
+    // plans the move of the player to move in the state by the moves the game expects to be left
+    template<class GameType, class StateType>
+    void StartMove(StateType const & state) {
+        if constexpr (boardgame::game_traits::kHasMovesToGo<GameType, StateType>) {
+            StartMove(GameType::MovesToGo(state));
+        } else {
+            StartMove(kDefaultMovesToGo);
+        }
+    }
+
+    // a move never takes more than half of the clock, so a wrong estimate of the
+    // moves to go costs time instead of the game
+    void StartMove(unsigned moves_to_go) {
+        double usable = static_cast<double>(std::max(0ll, remaining_ - kOverhead));
+        double base = std::min(usable / std::max(2u, moves_to_go) + 0.75 * increment_, usable / 2.0);
+
+        base_ = static_cast<long long>(base);
+        soft_ = base_;
+        hard_ = static_cast<long long>(std::min(base * kMaxExtension, usable / 2.0));
+        flips_ = 0;
+        has_best_move_ = false;
+    }
+
+    // whether the search goes on after elapsed milliseconds of the move with the best move so far
+    // every change of the best move adds to the soft limit, more when it comes late in the move
+    bool Continue(long long elapsed_in_milliseconds, std::uint64_t best_move) {
+        if (has_best_move_ && best_move != best_move_) {
+            flips_ += 1;
+            long long extension = elapsed_in_milliseconds * 2 >= soft_ ? base_ / 2 : base_ / 4;
+            soft_ = std::min(hard_, soft_ + extension);
+        }
+        best_move_ = best_move;
+        has_best_move_ = true;
+        return elapsed_in_milliseconds < soft_;
+    }
+
+    long long SoftLimit() const {
+        return soft_;
+    }
+
+    long long HardLimit() const {
+        return hard_;
+    }
+
+    // how often the best move changed during the move
+    unsigned Flips() const {
+        return flips_;
+    }
+
+private:
+    bool active_ = false;
+    long long remaining_ = 0;
+    long long increment_ = 0;
+
+    long long base_ = 0;
+    long long soft_ = 0;
+    long long hard_ = 0;
+    unsigned flips_ = 0;
+    bool has_best_move_ = false;
+    std::uint64_t best_move_ = 0;
+};
+
+} // namespace algorithm
+
+#endif /* MORRIS_ALGORITHMS_TIME_MANAGER_HPP_ */
@@ -0,0 +1,217 @@
+#ifndef MORRIS_GAMES_BATCH_HPP_
+#define MORRIS_GAMES_BATCH_HPP_
+
+#include "../utility/random.hpp"
+
+// the vector kernels of the batched rollouts need avx2, which MORRIS_NATIVE_ARCH turns on for
+// machines that have it, the other builds run the same lanes one after another
+#if defined(__AVX2__)
+#define MORRIS_BATCH_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace boardgame {
+
+// number of playouts that are advanced together in lockstep by the batched rollouts
+// the games first turn the states into bitboards and leave out the ones that already ended,
+// then a lane takes the next playout as soon as its own ended, so no lane waits for the longest one
+static const unsigned kBatchLanes = 16;
+
+template<class T>
+using Lanes = std::array<T, kBatchLanes>;
+
+// one xorshift generator per lane with the width of the lanes, all of them stepped at once
+// both the vector kernels and the lanes one after another draw the same numbers
+template<class Word>
+class LaneRandom {
+public:
+    static_assert(sizeof(Word) == 4 || sizeof(Word) == 8, "the lanes are 32 or 64 bits wide");
+
+    static constexpr unsigned kShiftA = 13;
+    static constexpr unsigned kShiftB = sizeof(Word) == 4 ? 17 : 7;
+    static constexpr unsigned kShiftC = sizeof(Word) == 4 ? 5 : 17;
+
+    explicit LaneRandom(std::uint64_t seed) {
+        for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+            // splitmix64 so that neighboring lanes get unrelated streams
+            Word z = static_cast<Word>(utility::SplitMix64(seed) >> (64 - 8 * sizeof(Word)));
+            state_[lane] = z == 0 ? 1 : z;
+        }
+    }
+
+    Lanes<Word> & State() {
+        return state_;
+    }
+
+    // for every lane a number in [0, bounds[lane]) from the top 16 bits with a multiply and
+    // a shift, which stays within 32 bits for bounds up to 65536
+    void Bounded(Lanes<std::uint32_t> const & bounds, Lanes<std::uint32_t> & draws) {
+        for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+            Word x = state_[lane];
+            x ^= x << kShiftA;
+            x ^= x >> kShiftB;
+            x ^= x << kShiftC;
+            state_[lane] = x;
+            draws[lane] = (static_cast<std::uint32_t>(x >> (8 * sizeof(Word) - 16)) * bounds[lane]) >> 16;
+        }
+    }
+
+private:
+    Lanes<Word> state_;
+};
+
+// for every lane the number of set bits
+template<class Word>
+void PopCount(Lanes<Word> const & masks, Lanes<std::uint32_t> & counts) {
+    for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+        Word x = masks[lane];
+        x = x - ((x >> 1) & static_cast<Word>(0x5555555555555555ull));
+        x = (x & static_cast<Word>(0x3333333333333333ull)) + ((x >> 2) & static_cast<Word>(0x3333333333333333ull));
+        x = (x + (x >> 4)) & static_cast<Word>(0x0f0f0f0f0f0f0f0full);
+        counts[lane] = static_cast<std::uint32_t>((x * static_cast<Word>(0x0101010101010101ull)) >> (8 * sizeof(Word) - 8));
+    }
+}
+
+// for every lane the k-th lowest set bit of candidates, found by clearing the lowest set bit
+// while fewer than k are cleared, a mask of at most MaxBits bits never needs more than MaxBits - 1
+template<unsigned MaxBits, class Word>
+void SelectBits(Lanes<Word> const & candidates, Lanes<std::uint32_t> const & k, Lanes<Word> & selected) {
+    for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+        Word mask = candidates[lane];
+        for (std::uint32_t cleared = 0; cleared + 1 < MaxBits; ++cleared) {
+            Word keep = Word(0) - static_cast<Word>(cleared >= k[lane]);
+            mask &= (mask - 1) | keep;
+        }
+        selected[lane] = mask & (Word(0) - mask);
+    }
+}
+
+// one bit per lane whose flag is set
+template<class Word>
+std::uint32_t LaneBits(Lanes<Word> const & flags) {
+    std::uint32_t bits = 0;
+    for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+        bits |= static_cast<std::uint32_t>(flags[lane] & 1) << lane;
+    }
+    return bits;
+}
+
+#ifdef MORRIS_BATCH_AVX2
+namespace batch_avx2 {
+
+// the number of set bits of every byte, from a table of the nibbles
+inline __m256i ByteCounts(__m256i x) {
+    const __m256i nibble_counts = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                   0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibbles = _mm256_set1_epi8(0x0f);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(nibble_counts, _mm256_and_si256(x, low_nibbles)),
+                           _mm256_shuffle_epi8(nibble_counts, _mm256_and_si256(_mm256_srli_epi16(x, 4), low_nibbles)));
+}
+
+inline __m256i PopCount32(__m256i x) {
+    return _mm256_madd_epi16(_mm256_maddubs_epi16(ByteCounts(x), _mm256_set1_epi8(1)), _mm256_set1_epi16(1));
+}
+
+inline __m256i PopCount64(__m256i x) {
+    return _mm256_sad_epu8(ByteCounts(x), _mm256_setzero_si256());
+}
+
+// one step of LaneRandom for 8 lanes of 32 bits, returns the draws below bounds
+inline __m256i Bounded32(__m256i & state, __m256i bounds) {
+    using Random = LaneRandom<std::uint32_t>;
+    __m256i x = state;
+    x = _mm256_xor_si256(x, _mm256_slli_epi32(x, Random::kShiftA));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, Random::kShiftB));
+    x = _mm256_xor_si256(x, _mm256_slli_epi32(x, Random::kShiftC));
+    state = x;
+    return _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(x, 16), bounds), 16);
+}
+
+// the same for 4 lanes of 64 bits
+inline __m256i Bounded64(__m256i & state, __m256i bounds) {
+    using Random = LaneRandom<std::uint64_t>;
+    __m256i x = state;
+    x = _mm256_xor_si256(x, _mm256_slli_epi64(x, Random::kShiftA));
+    x = _mm256_xor_si256(x, _mm256_srli_epi64(x, Random::kShiftB));
+    x = _mm256_xor_si256(x, _mm256_slli_epi64(x, Random::kShiftC));
+    state = x;
+    return _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 48), bounds), 16);
+}
+
+// the permutations that move the first popcount(mask) values to the set lanes of mask, in order,
+// for 8 lanes of 32 bits and, as pairs of 32 bit halves, for 4 lanes of 64 bits
+struct ExpandTable {
+    ExpandTable() {
+        for (unsigned mask = 0; mask < 256; ++mask) {
+            std::uint32_t next = 0;
+            for (unsigned lane = 0; lane < 8; ++lane) {
+                words[mask][lane] = (mask >> lane) & 1 ? next++ : 0;
+            }
+        }
+        for (unsigned mask = 0; mask < 16; ++mask) {
+            std::uint32_t next = 0;
+            for (unsigned lane = 0; lane < 4; ++lane) {
+                std::uint32_t source = (mask >> lane) & 1 ? next++ : 0;
+                halves[mask][2 * lane] = 2 * source;
+                halves[mask][2 * lane + 1] = 2 * source + 1;
+            }
+        }
+    }
+
+    alignas(32) std::uint32_t words[256][8];
+    alignas(32) std::uint32_t halves[16][8];
+};
+
+inline ExpandTable const & Expands() {
+    static const ExpandTable table;
+    return table;
+}
+
+// the set lanes of mask, one bit per 32 bit lane, take the next values from source in order
+inline __m256i Expand32(__m256i lanes, unsigned mask, std::uint32_t const * source) {
+    __m256i permutation = _mm256_load_si256(reinterpret_cast<__m256i const *>(Expands().words[mask]));
+    __m256i expanded = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(source)), permutation);
+    __m256i selected = _mm256_cmpgt_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(mask)),
+                                                           _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)), _mm256_setzero_si256());
+    return _mm256_blendv_epi8(lanes, expanded, selected);
+}
+
+// the set lanes of mask take the next numbers counting up from first, in order
+inline __m256i ExpandIndices32(__m256i lanes, unsigned mask, std::uint32_t first) {
+    __m256i permutation = _mm256_load_si256(reinterpret_cast<__m256i const *>(Expands().words[mask]));
+    __m256i selected = _mm256_cmpgt_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(mask)),
+                                                           _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)), _mm256_setzero_si256());
+    return _mm256_blendv_epi8(lanes, _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(first)), permutation), selected);
+}
+
+inline __m256i ExpandIndices64(__m256i lanes, unsigned mask, std::uint64_t first) {
+    __m256i permutation = _mm256_cvtepu32_epi64(_mm_load_si128(reinterpret_cast<__m128i const *>(Expands().words[mask])));
+    __m256i selected = _mm256_cmpgt_epi64(_mm256_and_si256(_mm256_set1_epi64x(mask),
+                                                           _mm256_setr_epi64x(1, 2, 4, 8)), _mm256_setzero_si256());
+    return _mm256_blendv_epi8(lanes, _mm256_add_epi64(_mm256_set1_epi64x(static_cast<long long>(first)), permutation), selected);
+}
+
+// the set lanes of mask, one bit per 64 bit lane, take the next values from source in order
+inline __m256i Expand64(__m256i lanes, unsigned mask, std::uint64_t const * source) {
+    __m256i permutation = _mm256_load_si256(reinterpret_cast<__m256i const *>(Expands().halves[mask]));
+    __m256i expanded = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(source)), permutation);
+    __m256i selected = _mm256_cmpgt_epi64(_mm256_and_si256(_mm256_set1_epi64x(mask),
+                                                           _mm256_setr_epi64x(1, 2, 4, 8)), _mm256_setzero_si256());
+    return _mm256_blendv_epi8(lanes, expanded, selected);
+}
+
+// one bit per 32 or 64 bit lane whose bits are all set
+inline unsigned LaneMask32(__m256i flags) {
+    return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(flags)));
+}
+
+inline unsigned LaneMask64(__m256i flags) {
+    return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(flags)));
+}
+
+} // namespace batch_avx2
+#endif
+
+} // namespace boardgame
+
+#endif /* MORRIS_GAMES_BATCH_HPP_ */
@@ -3,12 +3,13 @@
 
 namespace boardgame {
 
-void Connect4State::Print() {
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+void ConnectNState<Width, Height, ConnectCount>::Print() {
 
     std::cout << "Board:\n";
 
-    for (unsigned y = 0; y < Connect4State::kHeight; ++y) {
-        for (unsigned x = 0; x < Connect4State::kWidth; ++x) {
+    for (unsigned y = 0; y < kHeight; ++y) {
+        for (unsigned x = 0; x < kWidth; ++x) {
             if (board[x][y] == Player::kNone) {
                 std::cout << " 0 ";
             }
@@ -18,11 +19,11 @@ void Connect4State::Print() {
         }
         std::cout << "\n";
     }
-    for (unsigned i = 0; i < Connect4State::kWidth; ++i) {
+    for (unsigned i = 0; i < kWidth; ++i) {
         std::cout << "---";
     }
     std::cout << "\n";
-    for (unsigned i = 0; i < Connect4State::kWidth; ++i) {
+    for (unsigned i = 0; i < kWidth; ++i) {
         std::cout << " " + std::to_string(i) + " ";
     }
     std::cout << "\n";
@@ -30,19 +31,20 @@ void Connect4State::Print() {
     std::cout << (player == Player::kLeftPlayer ? "Player: Left\n" : "Player: Right\n");
 }
 
-std::tuple<bool, Player> Connect4::Winner(Connect4State const & state) {
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+std::tuple<bool, Player> ConnectN<Width, Height, ConnectCount>::Winner(StateType const & state) {
 
-    unsigned end_x = Connect4State::kWidth - Connect4State::kConnectCount;
-    unsigned end_y = Connect4State::kHeight - Connect4State::kConnectCount;
+    unsigned end_x = StateType::kWidth - StateType::kConnectCount;
+    unsigned end_y = StateType::kHeight - StateType::kConnectCount;
 
     // check horizontal
-    for (unsigned y = 0; y < Connect4State::kHeight; ++y) {
+    for (unsigned y = 0; y < StateType::kHeight; ++y) {
         for (unsigned x = 0; x <= end_x; ++x) {
             bool all_same = true;
             Player piece = state.board[x][y];
             if (piece == Player::kNone) continue;
 
-            for (unsigned i = 1; i < Connect4State::kConnectCount; ++i) {
+            for (unsigned i = 1; i < StateType::kConnectCount; ++i) {
                 if (state.board[x + i][y] != piece) {
                     all_same = false;
                     break;
@@ -55,13 +57,13 @@ std::tuple<bool, Player> Connect4::Winner(Connect4State const & state) {
     }
 
     // check vertical
-    for (unsigned x = 0; x < Connect4State::kWidth; ++x) {
+    for (unsigned x = 0; x < StateType::kWidth; ++x) {
         for (unsigned y = 0; y <= end_y; ++y) {
             bool all_same = true;
             Player piece = state.board[x][y];
             if (piece == Player::kNone) continue;
 
-            for (unsigned i = 1; i < Connect4State::kConnectCount; ++i) {
+            for (unsigned i = 1; i < StateType::kConnectCount; ++i) {
                 if (state.board[x][y + i] != piece) {
                     all_same = false;
                     break;
@@ -80,7 +82,7 @@ std::tuple<bool, Player> Connect4::Winner(Connect4State const & state) {
             Player piece = state.board[x][y];
             if (piece == Player::kNone) continue;
 
-            for (unsigned i = 1; i < Connect4State::kConnectCount; ++i) {
+            for (unsigned i = 1; i < StateType::kConnectCount; ++i) {
                 if (state.board[x + i][y + i] != piece) {
                     all_same = false;
                     break;
@@ -96,11 +98,11 @@ std::tuple<bool, Player> Connect4::Winner(Connect4State const & state) {
     for (unsigned x = 0; x <= end_x; ++x) {
         for (unsigned y = 0; y <= end_y; ++y) {
             bool all_same = true;
-            Player piece = state.board[x + Connect4State::kConnectCount - 1][y];
+            Player piece = state.board[x + StateType::kConnectCount - 1][y];
             if (piece == Player::kNone) continue;
 
-            for (unsigned i = 0; i < Connect4State::kConnectCount - 1; ++i) {
-                if (state.board[x + i][y + Connect4State::kConnectCount - 1 - i] != piece) {
+            for (unsigned i = 0; i < StateType::kConnectCount - 1; ++i) {
+                if (state.board[x + i][y + StateType::kConnectCount - 1 - i] != piece) {
                     all_same = false;
                     break;
                 }
@@ -111,7 +113,7 @@ std::tuple<bool, Player> Connect4::Winner(Connect4State const & state) {
         }
     }
 
-    for (unsigned x = 0; x < Connect4State::kWidth; ++x) {
+    for (unsigned x = 0; x < StateType::kWidth; ++x) {
         if (state.board[x][0] == Player::kNone) {
             return kOnGoingGame;
         }
@@ -120,7 +122,8 @@ std::tuple<bool, Player> Connect4::Winner(Connect4State const & state) {
     return { false, Player::kNone };
 }
 
-std::tuple<bool, std::array<double, 2>> Connect4::StateValue(Connect4State const &state, unsigned /*depth*/) {
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+std::tuple<bool, std::array<double, 2>> ConnectN<Width, Height, ConnectCount>::StateValue(StateType const &state, unsigned /*depth*/) {
     auto[on_going, winner] = Winner(state);
 
     if (winner == Player::kLeftPlayer) return { false, {1.0, 0.0} };
@@ -130,9 +133,16 @@ std::tuple<bool, std::array<double, 2>> Connect4::StateValue(Connect4State const
     return { on_going, {0.5, 0.5} };
 }
 
-std::vector<Connect4Move> Connect4::ListMoves(Connect4State const & state) {
-    std::vector<Connect4Move> moves;
-    for (unsigned x = 0; x < Connect4State::kWidth; ++x) {
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+std::array<double, 2> ConnectN<Width, Height, ConnectCount>::Evaluate(StateType const & /*state*/) {
+    // value of a game that was not played to the end, there is no cheap heuristic so it is even
+    return { 0.5, 0.5 };
+}
+
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+std::vector<ConnectNMove> ConnectN<Width, Height, ConnectCount>::ListMoves(StateType const & state) {
+    std::vector<ConnectNMove> moves;
+    for (unsigned x = 0; x < StateType::kWidth; ++x) {
         if (state.board[x][0] == Player::kNone) {
             moves.emplace_back(x);
         }
@@ -140,17 +150,52 @@ std::vector<Connect4Move> Connect4::ListMoves(Connect4State const & state) {
     return moves;
 }
 
-bool Connect4::IsValidMove(Connect4State const & state, Connect4Move const & move) {
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+bool ConnectN<Width, Height, ConnectCount>::IsValidMove(StateType const & state, ConnectNMove const & move) {
     return move.location >= 0
-        && move.location < Connect4State::kWidth
+        && move.location < StateType::kWidth
         && state.board[move.location][0] == Player::kNone;
 }
 
-Connect4State Connect4::ApplyMove(Connect4State const & state, Connect4Move const & move) {
-    Connect4State next_state(state);
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+int ConnectN<Width, Height, ConnectCount>::LandingRow(StateType const & state, unsigned x) {
+    for (int y = StateType::kHeight - 1; y >= 0; --y) {
+        if (state.board[x][y] == Player::kNone) return y;
+    }
+    return -1;
+}
+
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+bool ConnectN<Width, Height, ConnectCount>::ConnectsAt(StateType const & state, unsigned x, unsigned y, Player player) {
+    static const int kDirections[4][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, -1 } };
+
+    for (auto const & direction : kDirections) {
+        unsigned connected = 1;
+
+        // walk both ways from (x, y) while the pieces belong to player
+        for (int sign : { 1, -1 }) {
+            int cx = static_cast<int>(x) + sign * direction[0];
+            int cy = static_cast<int>(y) + sign * direction[1];
+            while (cx >= 0 && cx < static_cast<int>(StateType::kWidth) &&
+                   cy >= 0 && cy < static_cast<int>(StateType::kHeight) &&
+                   state.board[cx][cy] == player) {
+                ++connected;
+                cx += sign * direction[0];
+                cy += sign * direction[1];
+            }
+        }
+
+        if (connected >= StateType::kConnectCount) return true;
+    }
+    return false;
+}
+
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+ConnectNState<Width, Height, ConnectCount> ConnectN<Width, Height, ConnectCount>::ApplyMove(StateType const & state, ConnectNMove const & move) {
+    StateType next_state(state);
 
     // find the first empty position on the most bottom
-    for (int y = Connect4State::kHeight - 1; y >= 0; --y) {
+    for (int y = StateType::kHeight - 1; y >= 0; --y) {
         if (next_state.board[move.location][y] == Player::kNone) {
             next_state.board[move.location][y] = state.player;
             break;
@@ -160,10 +205,311 @@ Connect4State Connect4::ApplyMove(Connect4State const & state, Connect4Move cons
     return next_state;
 }
 
-Connect4State Connect4::SimulationPolicy(Connect4State const & state, std::mt19937_64 &random_engine) {
-    auto moves = ListMoves(state);
-    std::uniform_int_distribution<std::size_t> moves_distribution(0, moves.size() - 1);
-    return ApplyMove(state, moves[moves_distribution(random_engine)]);
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+std::uint64_t ConnectN<Width, Height, ConnectCount>::Hash(StateType const & state) {
+    static_assert(StateType::kWidth * (StateType::kHeight + 1) < 64, "the key must fit in 63 bits");
+
+    const unsigned kColumnBits = StateType::kHeight + 1;
+
+    std::uint64_t own = 0, mask = 0, bottom_row = 0;
+    for (unsigned x = 0; x < StateType::kWidth; ++x) {
+        bottom_row |= std::uint64_t(1) << (x * kColumnBits);
+        for (unsigned y = 0; y < StateType::kHeight; ++y) {
+            Player piece = state.board[x][y];
+            if (piece == Player::kNone) continue;
+
+            std::uint64_t bit = std::uint64_t(1) << (x * kColumnBits + StateType::kHeight - 1 - y);
+            mask |= bit;
+            if (piece == state.player) own |= bit;
+        }
+    }
+    return (own + mask + bottom_row) | (static_cast<std::uint64_t>(state.player) << 63);
+}
+
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+ConnectNState<Width, Height, ConnectCount> ConnectN<Width, Height, ConnectCount>::Transform(StateType const & state, unsigned symmetry) {
+    if (symmetry == 0) return state;
+
+    StateType next_state(state);
+    std::reverse(next_state.board.begin(), next_state.board.end());
+    return next_state;
+}
+
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+std::tuple<ConnectNState<Width, Height, ConnectCount>, unsigned> ConnectN<Width, Height, ConnectCount>::Canonical(StateType const & state) {
+    StateType mirror = Transform(state, 1);
+    if (Hash(mirror) < Hash(state)) return { mirror, 1 };
+    return { state, 0 };
+}
+
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+std::uint64_t ConnectN<Width, Height, ConnectCount>::CanonicalHash(StateType const & state) {
+    return std::min(Hash(state), Hash(Transform(state, 1)));
+}
+
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+double ConnectN<Width, Height, ConnectCount>::MovePrior(StateType const & state, ConnectNMove const & move) {
+    int y = LandingRow(state, move.location);
+    if (y < 0) return 1.0;
+    if (ConnectsAt(state, move.location, y, state.player)) return 4.0;
+    if (ConnectsAt(state, move.location, y, Opponent(state.player))) return 2.0;
+    if (y > 0 && ConnectsAt(state, move.location, y - 1, Opponent(state.player))) return 0.25;
+    return 1.0;
+}
+
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+unsigned ConnectN<Width, Height, ConnectCount>::MovesToGo(StateType const & state) {
+    unsigned empty = 0;
+    for (auto const & column : state.board) {
+        empty += static_cast<unsigned>(std::count(column.begin(), column.end(), Player::kNone));
+    }
+    return (empty + 1) / 2;
 }
 
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+void ConnectN<Width, Height, ConnectCount>::EncodeFeatures(StateType const & state, float * features) {
+    const unsigned kPlaneSize = StateType::kWidth * StateType::kHeight;
+    for (unsigned x = 0; x < StateType::kWidth; ++x) {
+        for (unsigned y = 0; y < StateType::kHeight; ++y) {
+            unsigned cell = x * StateType::kHeight + y;
+            features[cell] = state.board[x][y] == state.player ? 1.0f : 0.0f;
+            features[kPlaneSize + cell] = state.board[x][y] == Opponent(state.player) ? 1.0f : 0.0f;
+        }
+    }
 }
+
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+void ConnectN<Width, Height, ConnectCount>::BatchSimulate(std::vector<StateType> const & states, std::uint64_t seed, std::vector<std::array<double, 2>> & values) {
+    // bit x * kColumnBits + y is the cell in column x and row y counted from the bottom
+    // the extra bit on top of each column stays empty and stops lines from wrapping around
+    const unsigned kColumnBits = StateType::kHeight + 1;
+    const std::uint32_t kNone = static_cast<std::uint32_t>(Player::kNone);
+
+    std::uint64_t top_row = 0;
+    std::uint64_t full_board = 0;
+    for (unsigned x = 0; x < StateType::kWidth; ++x) {
+        top_row |= std::uint64_t(1) << (x * kColumnBits + StateType::kHeight - 1);
+        full_board |= ((std::uint64_t(1) << StateType::kHeight) - 1) << (x * kColumnBits);
+    }
+    const std::array<unsigned, 4> directions = { 1u, kColumnBits - 1, kColumnBits, kColumnBits + 1 };
+
+    // a bit of run stays set while the length pieces from it in the direction are all there,
+    // the length doubles every step and the last step adds what is left up to kConnectCount
+    auto connected = [&directions](std::uint64_t pieces) -> std::uint64_t {
+        std::uint64_t result = 0;
+        for (unsigned direction : directions) {
+            std::uint64_t run = pieces;
+            unsigned length = 1;
+            for (; 2 * length <= StateType::kConnectCount; length *= 2) {
+                run &= run >> (length * direction);
+            }
+            if (length < StateType::kConnectCount) run &= run >> ((StateType::kConnectCount - length) * direction);
+            result |= run;
+        }
+        return result;
+    };
+
+    // the states that go on as pieces of the player to move and all pieces, in the order the lanes
+    // take them, and the winner of each once it is played out
+    // the vector kernel reads a register past the last one, the padding keeps that in bounds
+    std::vector<std::uint64_t> owns, masks, players;
+    std::vector<std::uint32_t> origins, results(states.size(), kNone);
+    values.resize(states.size());
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        auto const & state = states[i];
+        std::uint64_t own = 0, mask = 0;
+        for (unsigned x = 0; x < StateType::kWidth; ++x) {
+            for (unsigned y = 0; y < StateType::kHeight; ++y) {
+                Player piece = state.board[x][y];
+                if (piece == Player::kNone) continue;
+
+                std::uint64_t bit = std::uint64_t(1) << (x * kColumnBits + StateType::kHeight - 1 - y);
+                mask |= bit;
+                if (piece == state.player) own |= bit;
+            }
+        }
+
+        if (connected(own ^ mask) != 0) results[i] = static_cast<std::uint32_t>(Opponent(state.player));
+        else if (connected(own) != 0) results[i] = static_cast<std::uint32_t>(state.player);
+        else if (mask != full_board) {
+            owns.push_back(own);
+            masks.push_back(mask);
+            players.push_back(static_cast<std::uint64_t>(state.player));
+            origins.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    std::uint32_t count = static_cast<std::uint32_t>(owns.size());
+    for (auto * lanes : { &owns, &masks, &players }) {
+        lanes->resize(count + 2 * kBatchLanes);
+    }
+    std::vector<std::uint32_t> outcomes(count);
+
+    LaneRandom<std::uint64_t> random(seed);
+    if (count > 0) {
+#ifdef MORRIS_BATCH_AVX2
+        using namespace batch_avx2;
+        const __m256i top = _mm256_set1_epi64x(static_cast<long long>(top_row));
+        const __m256i full = _mm256_set1_epi64x(static_cast<long long>(full_board));
+        const __m256i none = _mm256_set1_epi64x(kNone);
+        const __m256i one = _mm256_set1_epi64x(1);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i total = _mm256_set1_epi64x(count);
+
+        auto vector_connected = [&directions](__m256i pieces) {
+            __m256i result = _mm256_setzero_si256();
+            for (unsigned direction : directions) {
+                __m256i run = pieces;
+                unsigned length = 1;
+                for (; 2 * length <= StateType::kConnectCount; length *= 2) {
+                    run = _mm256_and_si256(run, _mm256_srli_epi64(run, static_cast<int>(length * direction)));
+                }
+                if (length < StateType::kConnectCount) {
+                    run = _mm256_and_si256(run, _mm256_srli_epi64(run, static_cast<int>((StateType::kConnectCount - length) * direction)));
+                }
+                result = _mm256_or_si256(result, run);
+            }
+            return result;
+        };
+
+        // four registers of 4 lanes, the lanes of each follow the ones of the one before
+        __m256i own[4], mask[4], player[4], index[4], active[4], state[4];
+        std::uint32_t next = 0;
+        for (unsigned quarter = 0; quarter < 4; ++quarter, next += 4) {
+            own[quarter] = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(owns.data() + next));
+            mask[quarter] = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(masks.data() + next));
+            player[quarter] = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(players.data() + next));
+            index[quarter] = _mm256_add_epi64(_mm256_set1_epi64x(next), _mm256_setr_epi64x(0, 1, 2, 3));
+            active[quarter] = _mm256_cmpgt_epi64(total, index[quarter]);
+            state[quarter] = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(random.State().data() + 4 * quarter));
+        }
+
+        for (;;) {
+            unsigned finished[4];
+            __m256i result[4];
+            for (unsigned quarter = 0; quarter < 4; ++quarter) {
+                __m256i open = _mm256_andnot_si256(mask[quarter], top);
+                __m256i draw = Bounded64(state[quarter], PopCount64(open));
+
+                // clear the lowest open column while fewer than draw are cleared, then keep the lowest one left
+                __m256i columns = open;
+                for (long long cleared = 0; cleared + 1 < static_cast<long long>(StateType::kWidth); ++cleared) {
+                    __m256i clear = _mm256_cmpgt_epi64(draw, _mm256_set1_epi64x(cleared));
+                    columns = _mm256_andnot_si256(_mm256_andnot_si256(_mm256_sub_epi64(columns, one), clear), columns);
+                }
+                __m256i column_bottom = _mm256_srli_epi64(_mm256_and_si256(columns, _mm256_sub_epi64(zero, columns)), StateType::kHeight - 1);
+
+                // adding the bottom bit carries up to the first empty cell of the column
+                __m256i next_mask = _mm256_or_si256(mask[quarter], _mm256_add_epi64(mask[quarter], column_bottom));
+                __m256i mover = _mm256_or_si256(own[quarter], _mm256_xor_si256(next_mask, mask[quarter]));
+
+                __m256i won = _mm256_xor_si256(_mm256_cmpeq_epi64(vector_connected(mover), zero), _mm256_set1_epi64x(-1));
+                __m256i ended = _mm256_or_si256(won, _mm256_cmpeq_epi64(next_mask, full));
+
+                finished[quarter] = LaneMask64(_mm256_and_si256(active[quarter], ended));
+                result[quarter] = _mm256_blendv_epi8(none, player[quarter], won);
+                own[quarter] = _mm256_xor_si256(mover, next_mask);
+                mask[quarter] = next_mask;
+                player[quarter] = _mm256_xor_si256(player[quarter], one);
+            }
+            if ((finished[0] | finished[1] | finished[2] | finished[3]) == 0) continue;
+
+            // the finished lanes hand in their winner and take the next states in lane order
+            for (unsigned quarter = 0; quarter < 4; ++quarter) {
+                if (finished[quarter] == 0) continue;
+
+                alignas(32) std::array<std::uint64_t, 4> indices, winners;
+                _mm256_store_si256(reinterpret_cast<__m256i *>(indices.data()), index[quarter]);
+                _mm256_store_si256(reinterpret_cast<__m256i *>(winners.data()), result[quarter]);
+                std::uint32_t taken = 0;
+                for (unsigned lane = 0; lane < 4; ++lane) {
+                    if ((finished[quarter] >> lane & 1) == 0) continue;
+                    outcomes[indices[lane]] = static_cast<std::uint32_t>(winners[lane]);
+                    taken += 1;
+                }
+
+                own[quarter] = Expand64(own[quarter], finished[quarter], owns.data() + next);
+                mask[quarter] = Expand64(mask[quarter], finished[quarter], masks.data() + next);
+                player[quarter] = Expand64(player[quarter], finished[quarter], players.data() + next);
+                index[quarter] = ExpandIndices64(index[quarter], finished[quarter], next);
+                active[quarter] = _mm256_cmpgt_epi64(total, index[quarter]);
+                next += taken;
+            }
+
+            unsigned running = 0;
+            for (unsigned quarter = 0; quarter < 4; ++quarter) {
+                running |= LaneMask64(active[quarter]);
+            }
+            if (running == 0) break;
+        }
+#else
+        Lanes<std::uint64_t> own, mask, player;
+        Lanes<std::uint32_t> index, active;
+        std::uint32_t next = 0;
+
+        // a lane takes the next state that goes on, once they are all taken it idles
+        auto load = [&](unsigned lane) {
+            active[lane] = next < count;
+            if (!active[lane]) return;
+            own[lane] = owns[next];
+            mask[lane] = masks[next];
+            player[lane] = players[next];
+            index[lane] = next++;
+        };
+        for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+            load(lane);
+        }
+
+        Lanes<std::uint64_t> open, picked;
+        Lanes<std::uint32_t> counts, draws, finished, result;
+        while (LaneBits(active) != 0) {
+
+            // a column is open while its top cell is empty, pick one of them uniformly
+            // idle lanes play on without being read
+            for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+                open[lane] = ~mask[lane] & top_row;
+            }
+            PopCount(open, counts);
+            random.Bounded(counts, draws);
+            SelectBits<StateType::kWidth>(open, draws, picked);
+
+            for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+                // adding the bottom bit carries up to the first empty cell of the column
+                std::uint64_t next_mask = mask[lane] | (mask[lane] + (picked[lane] >> (StateType::kHeight - 1)));
+                std::uint64_t mover = own[lane] | (next_mask ^ mask[lane]);
+
+                std::uint32_t won = static_cast<std::uint32_t>(connected(mover) != 0);
+                std::uint32_t full = static_cast<std::uint32_t>(next_mask == full_board);
+
+                finished[lane] = active[lane] & (won | full);
+                result[lane] = won ? static_cast<std::uint32_t>(player[lane]) : kNone;
+
+                own[lane] = mover ^ next_mask;
+                mask[lane] = next_mask;
+                player[lane] ^= 1;
+            }
+
+            for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+                if (!finished[lane]) continue;
+                outcomes[index[lane]] = result[lane];
+                load(lane);
+            }
+        }
+#endif
+    }
+
+    for (std::uint32_t i = 0; i < count; ++i) {
+        results[origins[i]] = outcomes[i];
+    }
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        if (results[i] == static_cast<std::uint32_t>(Player::kLeftPlayer)) values[i] = { 1.0, 0.0 };
+        else if (results[i] == static_cast<std::uint32_t>(Player::kRightPlayer)) values[i] = { 0.0, 1.0 };
+        else values[i] = { 0.5, 0.5 };
+    }
+}
+
+template struct ConnectNState<6, 7, 4>;
+template class ConnectN<6, 7, 4>;
+template struct ConnectNState<7, 8, 5>;
+template class ConnectN<7, 8, 5>;
+
+} // namespace boardgame
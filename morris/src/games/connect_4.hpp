@@ -2,22 +2,26 @@
 #define MORRIS_GAMES_CONNECT_4_HPP_
 
 #include "simulation.hpp"
+#include "batch.hpp"
+#include "../utility/random.hpp"
 
 namespace boardgame {
 
-struct Connect4Move {
-    Connect4Move(unsigned int location) : location(location) {}
+struct ConnectNMove {
+    ConnectNMove(unsigned int location) : location(location) {}
     unsigned int location;
 };
 
-struct Connect4State {
-    static const unsigned kHeight = 7;
-    static const unsigned kWidth = 6;
-    static const unsigned kConnectCount = 4;
+// a board of Width columns of Height cells where ConnectCount pieces in a row win
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+struct ConnectNState {
+    static const unsigned kHeight = Height;
+    static const unsigned kWidth = Width;
+    static const unsigned kConnectCount = ConnectCount;
 
-    Connect4State(Player player) : player(player) {
-        for (unsigned x = 0; x < Connect4State::kWidth; ++x) {
-            for (unsigned y = 0; y < Connect4State::kHeight; ++y) {
+    ConnectNState(Player player) : player(player) {
+        for (unsigned x = 0; x < kWidth; ++x) {
+            for (unsigned y = 0; y < kHeight; ++y) {
                 board[x][y] = Player::kNone;
             }
         }
@@ -25,20 +29,157 @@ struct Connect4State {
 
     void Print();
 
+    bool operator==(ConnectNState const & other) const {
+        return player == other.player && board == other.board;
+    }
+
     Player player;
     std::array<std::array<Player, kHeight>, kWidth> board;
 };
 
-class Connect4 {
+// the game on every board size gets its own code with the sizes known when compiling
+// the bitboards have a column of kHeight + 1 bits per x and must fit in 64 bits
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+class ConnectN {
 public:
-    static std::tuple<bool, Player> Winner(Connect4State const & state);
-    static std::tuple<bool, std::array<double, 2>> StateValue(Connect4State const & state, unsigned depth = 0);
-    static std::vector<Connect4Move> ListMoves(Connect4State const & state);
-    static bool IsValidMove(Connect4State const & state, Connect4Move const & move);
-    static Connect4State ApplyMove(Connect4State const & state, Connect4Move const & move);
-    static Connect4State SimulationPolicy(Connect4State const & state, std::mt19937_64 &random_engine);
+    using StateType = ConnectNState<Width, Height, ConnectCount>;
+
+    static_assert(ConnectCount >= 2 && ConnectCount <= std::min(Width, Height), "a line must fit across the board");
+    static_assert(Width * (Height + 1) < 64, "the bitboard and the player to move must fit in 64 bits");
+
+    // moves are numbered by MoveIndex from 0 to kMoveIndexCount - 1
+    static const unsigned kMoveIndexCount = StateType::kWidth;
+
+    // most moves a state can have, one per column
+    static const unsigned kMaxBranchingFactor = StateType::kWidth;
+
+    static std::tuple<bool, Player> Winner(StateType const & state);
+    static std::tuple<bool, std::array<double, 2>> StateValue(StateType const & state, unsigned depth = 0);
+    static std::array<double, 2> Evaluate(StateType const & state);
+    static std::vector<ConnectNMove> ListMoves(StateType const & state);
+
+    // key that is different for every position, on the bitboard of BatchSimulate it is the pieces
+    // of the player to move plus all pieces plus the bottom row, with the player to move on top
+    static std::uint64_t Hash(StateType const & state);
+
+    // the board and its mirror image from left to right
+    static const unsigned kSymmetryCount = 2;
+
+    // the state with the board mirrored when symmetry is 1
+    static StateType Transform(StateType const & state, unsigned symmetry);
+
+    static ConnectNMove TransformMove(ConnectNMove const & move, unsigned symmetry) {
+        return ConnectNMove(symmetry == 0 ? move.location : StateType::kWidth - 1 - move.location);
+    }
+
+    // the symmetry that turns the board back, mirroring undoes itself
+    static unsigned InverseSymmetry(unsigned symmetry) {
+        return symmetry;
+    }
+
+    // the symmetric state with the lowest hash and the symmetry that turns state into it
+    static std::tuple<StateType, unsigned> Canonical(StateType const & state);
+
+    // Hash of the canonical form, the same for a board and its mirror image
+    static std::uint64_t CanonicalHash(StateType const & state);
+
+    // inputs of a network, a plane of the cells of the player to move and one of the opponent
+    static const unsigned kFeatureCount = 2 * StateType::kWidth * StateType::kHeight;
+    static void EncodeFeatures(StateType const & state, float * features);
+    static unsigned MoveIndex(ConnectNMove const & move) {
+        return move.location;
+    }
+
+    // small number that stands for the move in a game record
+    static std::uint16_t EncodeMove(ConnectNMove const & move) {
+        return static_cast<std::uint16_t>(move.location);
+    }
+    static ConnectNMove DecodeMove(std::uint16_t code) {
+        return ConnectNMove(code);
+    }
+
+    static bool IsValidMove(StateType const & state, ConnectNMove const & move);
+    static StateType ApplyMove(StateType const & state, ConnectNMove const & move);
+
+    // draws a uniform random column that is not full without listing all the moves
+    template<class RandomEngineType>
+    static ConnectNMove RandomMove(StateType const & state, RandomEngineType &random_engine) {
+        unsigned open_count = 0;
+        for (unsigned x = 0; x < StateType::kWidth; ++x) {
+            open_count += state.board[x][0] == Player::kNone;
+        }
+
+        unsigned k = utility::Bounded(random_engine, open_count);
+        for (unsigned x = 0; x < StateType::kWidth; ++x) {
+            if (state.board[x][0] == Player::kNone && k-- == 0) return ConnectNMove(x);
+        }
+        return ConnectNMove(StateType::kWidth);
+    }
+
+    // win if possible, otherwise block the opponent's win, otherwise play a random column
+    // that does not let the opponent win right on top of the new piece
+    template<class RandomEngineType>
+    static ConnectNMove HeavyMove(StateType const & state, RandomEngineType &random_engine) {
+        Player opponent = Opponent(state.player);
+
+        std::array<unsigned, StateType::kWidth> columns;
+        for (auto player : { state.player, opponent }) {
+            unsigned count = 0;
+            for (unsigned x = 0; x < StateType::kWidth; ++x) {
+                int y = LandingRow(state, x);
+                if (y >= 0 && ConnectsAt(state, x, y, player)) columns[count++] = x;
+            }
+            if (count > 0) return ConnectNMove(columns[utility::Bounded(random_engine, count)]);
+        }
+
+        unsigned count = 0;
+        for (unsigned x = 0; x < StateType::kWidth; ++x) {
+            int y = LandingRow(state, x);
+            if (y > 0 && ConnectsAt(state, x, y - 1, opponent)) continue;
+            if (y >= 0) columns[count++] = x;
+        }
+        if (count > 0) return ConnectNMove(columns[utility::Bounded(random_engine, count)]);
+
+        return RandomMove(state, random_engine);
+    }
+
+    // weight of a move for the search to try it first, winning moves before blocking moves before
+    // the rest, and least of all moves that let the opponent win on top of the new piece
+    static double MovePrior(StateType const & state, ConnectNMove const & move);
+
+    // moves the player to move has left if the board fills up, which the time manager spreads the clock over
+    static unsigned MovesToGo(StateType const & state);
+
+    // row a piece dropped in column x lands on, or -1 when the column is full
+    static int LandingRow(StateType const & state, unsigned x);
+
+    // whether a piece of player at (x, y) would connect kConnectCount pieces
+    static bool ConnectsAt(StateType const & state, unsigned x, unsigned y, Player player);
+
+    template<class RandomEngineType>
+    static StateType SimulationPolicy(StateType const & state, RandomEngineType &random_engine) {
+        return ApplyMove(state, RandomMove(state, random_engine));
+    }
+
+    // play every state to the end with uniform random moves, kBatchLanes playouts at a time
+    // the playouts run on bitboards with one column of kHeight + 1 bits per x
+    static void BatchSimulate(std::vector<StateType> const & states, std::uint64_t seed, std::vector<std::array<double, 2>> & values);
 };
 
+// the code of every board size is compiled once in connect_4.cpp
+extern template struct ConnectNState<6, 7, 4>;
+extern template class ConnectN<6, 7, 4>;
+extern template struct ConnectNState<7, 8, 5>;
+extern template class ConnectN<7, 8, 5>;
+
+using Connect4Move = ConnectNMove;
+using Connect4State = ConnectNState<6, 7, 4>;
+using Connect4 = ConnectN<6, 7, 4>;
+
+// five in a row on seven columns of eight, the largest board that still fits the bitboards
+using Connect5State = ConnectNState<7, 8, 5>;
+using Connect5 = ConnectN<7, 8, 5>;
+
 } // namespace boardgame
 
 #endif /* MORRIS_GAMES_CONNECT_4_HPP_ */
@@ -0,0 +1,296 @@
+#ifndef MORRIS_GAMES_GAME_RECORD_HPP_
+#define MORRIS_GAMES_GAME_RECORD_HPP_
+
+#include "simulation.hpp"
+#include "../utility/mapped_file.hpp"
+
+namespace boardgame {
+
+// binary file of many played games
+//
+// header  "MRRC", u32 version
+// games   u8 start, [the raw initial state when start is kCustomStart], varint move count,
+//         a varint per move from the game's EncodeMove, u8 result
+// index   u64 offset of every game
+// footer  u64 game count, u64 offset of the index, "MRIX", u32 version
+//
+// numbers are little endian, games that start from the usual empty board only store who starts
+// so a game of Nine Men's Morris takes one byte per placement and two per other move
+namespace record {
+
+static const std::uint32_t kVersion = 1;
+static const std::array<char, 4> kHeaderMagic = { 'M', 'R', 'R', 'C' };
+static const std::array<char, 4> kFooterMagic = { 'M', 'R', 'I', 'X' };
+static const std::size_t kHeaderSize = 8;
+static const std::size_t kFooterSize = 24;
+
+// the start byte, a player index for the usual initial state of that player
+static const std::uint8_t kCustomStart = 2;
+
+// the result byte, a player index or kNone for a draw
+static const std::uint8_t kUnfinished = 3;
+
+inline void WriteVarint(std::vector<std::uint8_t> & out, std::uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+// returns false when the data ends before the number does
+inline bool ReadVarint(std::uint8_t const * & in, std::uint8_t const * end, std::uint32_t & value) {
+    value = 0;
+    for (unsigned shift = 0; in < end && shift < 32; shift += 7) {
+        std::uint8_t byte = *in++;
+        value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+template<class T>
+void WriteLittleEndian(std::vector<std::uint8_t> & out, T value) {
+    for (unsigned i = 0; i < sizeof(T); ++i) {
+        out.push_back(static_cast<std::uint8_t>(static_cast<std::uint64_t>(value) >> (8 * i)));
+    }
+}
+
+template<class T>
+T ReadLittleEndian(std::uint8_t const * in) {
+    std::uint64_t value = 0;
+    for (unsigned i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<std::uint64_t>(in[i]) << (8 * i);
+    }
+    return static_cast<T>(value);
+}
+
+} // namespace record
+
+// the move that turns state into next_state, found among the legal moves of state
+template<class GameType, class StateType>
+auto InferMove(StateType const & state, StateType const & next_state) {
+    using MoveType = typename decltype(GameType::ListMoves(state))::value_type;
+    for (auto const & move : GameType::ListMoves(state)) {
+        auto candidate = GameType::ApplyMove(state, move);
+        if (candidate.player == next_state.player && candidate.board == next_state.board) {
+            return std::optional<MoveType>(move);
+        }
+    }
+    return std::optional<MoveType>();
+}
+
+template<class StateType, class MoveType>
+struct GameRecord {
+    StateType initial_state;
+    std::vector<MoveType> moves;
+
+    // {game is ongoing, the winner} like the games' Winner
+    std::tuple<bool, Player> winner;
+};
+
+// appends games to a record file, the index is written by Close or the destructor
+template<class GameType, class StateType, class MoveType>
+class GameRecordWriter {
+public:
+    static_assert(std::is_trivially_copyable<StateType>::value, "custom initial states are stored as raw bytes");
+
+    explicit GameRecordWriter(std::string const & path) : file_(path, std::ios::binary | std::ios::trunc) {
+        std::vector<std::uint8_t> header(record::kHeaderMagic.begin(), record::kHeaderMagic.end());
+        record::WriteLittleEndian(header, record::kVersion);
+        Write(header);
+    }
+
+    ~GameRecordWriter() {
+        Close();
+    }
+
+    GameRecordWriter(GameRecordWriter const &) = delete;
+    GameRecordWriter & operator=(GameRecordWriter const &) = delete;
+
+    bool IsOpen() const {
+        return file_.is_open() && file_.good();
+    }
+
+    std::size_t GameCount() const {
+        return offsets_.size();
+    }
+
+    void BeginGame(StateType const & initial_state) {
+        game_.clear();
+        moves_.clear();
+        last_state_.emplace(initial_state);
+
+        if (initial_state == StateType(initial_state.player)) {
+            game_.push_back(static_cast<std::uint8_t>(initial_state.player));
+        } else {
+            game_.push_back(record::kCustomStart);
+            auto const * bytes = reinterpret_cast<std::uint8_t const *>(&initial_state);
+            game_.insert(game_.end(), bytes, bytes + sizeof(StateType));
+        }
+    }
+
+    void AddMove(StateType const & state, MoveType const & move) {
+        moves_.push_back(GameType::EncodeMove(move));
+        last_state_.emplace(GameType::ApplyMove(state, move));
+    }
+
+    // for the players that only return the next state, the move is looked up
+    // returns false when no legal move leads there
+    bool AddState(StateType const & state, StateType const & next_state) {
+        auto move = InferMove<GameType>(state, next_state);
+        if (!move) return false;
+        AddMove(state, *move);
+        return true;
+    }
+
+    void EndGame() {
+        if (!last_state_) return;
+
+        record::WriteVarint(game_, static_cast<std::uint32_t>(moves_.size()));
+        for (auto code : moves_) {
+            record::WriteVarint(game_, code);
+        }
+
+        auto [on_going, winner] = GameType::Winner(*last_state_);
+        game_.push_back(on_going ? record::kUnfinished : static_cast<std::uint8_t>(winner));
+
+        offsets_.push_back(offset_);
+        Write(game_);
+        last_state_.reset();
+    }
+
+    // a whole game at once from the history of a Simulation
+    void WriteGame(std::vector<StateType> const & history) {
+        BeginGame(history.front());
+        for (std::size_t i = 1; i < history.size(); ++i) {
+            if (!AddState(history[i - 1], history[i])) break;
+        }
+        EndGame();
+    }
+
+    void Close() {
+        if (!file_.is_open()) return;
+        EndGame();
+
+        std::vector<std::uint8_t> index;
+        index.reserve(offsets_.size() * 8 + record::kFooterSize);
+        std::uint64_t index_offset = offset_;
+        for (auto offset : offsets_) {
+            record::WriteLittleEndian(index, offset);
+        }
+        record::WriteLittleEndian(index, static_cast<std::uint64_t>(offsets_.size()));
+        record::WriteLittleEndian(index, index_offset);
+        index.insert(index.end(), record::kFooterMagic.begin(), record::kFooterMagic.end());
+        record::WriteLittleEndian(index, record::kVersion);
+        Write(index);
+
+        file_.close();
+    }
+
+private:
+    void Write(std::vector<std::uint8_t> const & bytes) {
+        file_.write(reinterpret_cast<char const *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        offset_ += bytes.size();
+    }
+
+    std::ofstream file_;
+    std::uint64_t offset_ = 0;
+    std::vector<std::uint64_t> offsets_;
+
+    // the game being written
+    std::vector<std::uint8_t> game_;
+    std::vector<std::uint16_t> moves_;
+    std::optional<StateType> last_state_;
+};
+
+// reads games of a record file by their index without loading the whole file
+template<class GameType, class StateType, class MoveType>
+class GameRecordReader {
+public:
+    explicit GameRecordReader(std::string const & path) : file_(path) {
+        if (!file_.IsOpen() || file_.Size() < record::kHeaderSize + record::kFooterSize) return;
+
+        auto const * data = file_.Data();
+        auto const * footer = data + file_.Size() - record::kFooterSize;
+        if (!std::equal(record::kHeaderMagic.begin(), record::kHeaderMagic.end(), data) ||
+            !std::equal(record::kFooterMagic.begin(), record::kFooterMagic.end(), footer + 16) ||
+            record::ReadLittleEndian<std::uint32_t>(data + 4) != record::kVersion) {
+            return;
+        }
+
+        game_count_ = record::ReadLittleEndian<std::uint64_t>(footer);
+        index_offset_ = record::ReadLittleEndian<std::uint64_t>(footer + 8);
+        if (index_offset_ + game_count_ * 8 + record::kFooterSize != file_.Size()) return;
+
+        valid_ = true;
+    }
+
+    bool IsOpen() const {
+        return valid_;
+    }
+
+    std::size_t GameCount() const {
+        return valid_ ? static_cast<std::size_t>(game_count_) : 0;
+    }
+
+    // returns false when the game is out of range or cut short
+    bool Game(std::size_t index, GameRecord<StateType, MoveType> & game) const {
+        if (index >= GameCount()) return false;
+
+        auto const * data = file_.Data();
+        std::uint64_t begin = record::ReadLittleEndian<std::uint64_t>(data + index_offset_ + index * 8);
+        std::uint64_t end = index + 1 < game_count_ ?
+            record::ReadLittleEndian<std::uint64_t>(data + index_offset_ + (index + 1) * 8) : index_offset_;
+        if (begin >= end || end > index_offset_) return false;
+
+        auto const * in = data + begin;
+        auto const * in_end = data + end;
+
+        std::uint8_t start = *in++;
+        if (start == record::kCustomStart) {
+            if (in_end - in < static_cast<std::ptrdiff_t>(sizeof(StateType))) return false;
+            std::memcpy(&game.initial_state, in, sizeof(StateType));
+            in += sizeof(StateType);
+        } else {
+            game.initial_state = StateType(static_cast<Player>(start));
+        }
+
+        std::uint32_t move_count;
+        if (!record::ReadVarint(in, in_end, move_count)) return false;
+        game.moves.clear();
+        for (std::uint32_t i = 0; i < move_count; ++i) {
+            std::uint32_t code;
+            if (!record::ReadVarint(in, in_end, code)) return false;
+            game.moves.push_back(GameType::DecodeMove(static_cast<std::uint16_t>(code)));
+        }
+
+        if (in == in_end) return false;
+        std::uint8_t result = *in;
+        game.winner = result == record::kUnfinished ? kOnGoingGame : std::make_tuple(false, static_cast<Player>(result));
+        return true;
+    }
+
+    // every state of the game, played again through ApplyMove
+    std::vector<StateType> Replay(std::size_t index) const {
+        std::vector<StateType> states;
+        GameRecord<StateType, MoveType> game { StateType(Player::kLeftPlayer), {}, kOnGoingGame };
+        if (!Game(index, game)) return states;
+
+        states.push_back(game.initial_state);
+        for (auto const & move : game.moves) {
+            states.push_back(GameType::ApplyMove(states.back(), move));
+        }
+        return states;
+    }
+
+private:
+    utility::MappedFile file_;
+    bool valid_ = false;
+    std::uint64_t game_count_ = 0;
+    std::uint64_t index_offset_ = 0;
+};
+
+} // namespace boardgame
+
+#endif /* MORRIS_GAMES_GAME_RECORD_HPP_ */
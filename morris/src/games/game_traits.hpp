@@ -0,0 +1,101 @@
+#ifndef MORRIS_GAMES_GAME_TRAITS_HPP_
+#define MORRIS_GAMES_GAME_TRAITS_HPP_
+
+#include "simulation.hpp"
+
+namespace boardgame {
+
+// the interface the searches expect from a game, a class of static functions over a state and a move
+// CheckGame fails to compile with a message naming the first missing part
+namespace game_traits {
+
+struct Missing {};
+
+template<class, template<class...> class Operation, class... Arguments>
+struct Detector : std::false_type {
+    using type = Missing;
+};
+
+template<template<class...> class Operation, class... Arguments>
+struct Detector<std::void_t<Operation<Arguments...>>, Operation, Arguments...> : std::true_type {
+    using type = Operation<Arguments...>;
+};
+
+template<template<class...> class Operation, class... Arguments>
+constexpr bool kIsDetected = Detector<void, Operation, Arguments...>::value;
+
+// the type the operation gives, or Missing when it does not compile
+template<template<class...> class Operation, class... Arguments>
+using Detected = typename Detector<void, Operation, Arguments...>::type;
+
+template<class GameType, class StateType>
+using ListMoves = decltype(GameType::ListMoves(std::declval<StateType const &>()));
+
+template<class GameType, class StateType, class MoveType>
+using ApplyMove = decltype(GameType::ApplyMove(std::declval<StateType const &>(), std::declval<MoveType const &>()));
+
+template<class GameType, class StateType>
+using Winner = decltype(GameType::Winner(std::declval<StateType const &>()));
+
+template<class GameType, class StateType>
+using StateValue = decltype(std::get<1>(GameType::StateValue(std::declval<StateType const &>())));
+
+template<class GameType, class StateType>
+using Evaluate = decltype(GameType::Evaluate(std::declval<StateType const &>()));
+
+template<class GameType, class MoveType>
+using MoveIndex = decltype(GameType::MoveIndex(std::declval<MoveType const &>()));
+
+template<class GameType>
+using MoveIndexCount = decltype(GameType::kMoveIndexCount);
+
+template<class GameType>
+using MaxBranchingFactor = decltype(GameType::kMaxBranchingFactor);
+
+template<class StateType>
+using PlayerToMove = decltype(std::declval<StateType const &>().player);
+
+template<class GameType, class StateType>
+using CanonicalHash = decltype(GameType::CanonicalHash(std::declval<StateType const &>()));
+
+// whether the game maps symmetric states to one canonical form, which games may leave out
+template<class GameType, class StateType>
+constexpr bool kHasSymmetries = kIsDetected<CanonicalHash, GameType, StateType>;
+
+template<class GameType, class StateType>
+using MovesToGo = decltype(GameType::MovesToGo(std::declval<StateType const &>()));
+
+// whether the game estimates how many moves are left, which games may leave out
+template<class GameType, class StateType>
+constexpr bool kHasMovesToGo = kIsDetected<MovesToGo, GameType, StateType>;
+
+} // namespace game_traits
+
+template<class GameType, class StateType, class MoveType>
+constexpr bool CheckGame() {
+    using namespace game_traits;
+
+    static_assert(std::is_copy_constructible<StateType>::value && std::is_constructible<StateType, Player>::value,
+        "a state is copyable and made from the player to move");
+    static_assert(std::is_same<typename std::decay<Detected<PlayerToMove, StateType>>::type, Player>::value,
+        "a state has the member Player player");
+    static_assert(std::is_same<Detected<ListMoves, GameType, StateType>, std::vector<MoveType>>::value,
+        "the game has static std::vector<MoveType> ListMoves(StateType const &)");
+    static_assert(std::is_same<Detected<ApplyMove, GameType, StateType, MoveType>, StateType>::value,
+        "the game has static StateType ApplyMove(StateType const &, MoveType const &)");
+    static_assert(std::is_same<Detected<Winner, GameType, StateType>, std::tuple<bool, Player>>::value,
+        "the game has static std::tuple<bool, Player> Winner(StateType const &)");
+    static_assert(kIsDetected<StateValue, GameType, StateType>,
+        "the game has static std::tuple<bool, std::array<double, players>> StateValue(StateType const &, unsigned depth = 0)");
+    static_assert(kIsDetected<Evaluate, GameType, StateType>,
+        "the game has static std::array<double, players> Evaluate(StateType const &)");
+    static_assert(std::is_convertible<Detected<MoveIndex, GameType, MoveType>, unsigned>::value,
+        "the game has static unsigned MoveIndex(MoveType const &)");
+    static_assert(kIsDetected<MoveIndexCount, GameType> && kIsDetected<MaxBranchingFactor, GameType>,
+        "the game has the constants kMoveIndexCount and kMaxBranchingFactor");
+    return true;
+}
+
+} // namespace boardgame
+
+#endif /* MORRIS_GAMES_GAME_TRAITS_HPP_ */
@@ -1,110 +1,265 @@
 #include "../pch.hpp"
 #include "nine_men_morris.hpp"
 
+// the bitboards of the pieces compare four spots at once where sse2 is there, which is every x86-64
+#if defined(__SSE2__) || defined(_M_X64)
+#define MORRIS_PIECES_SSE2 1
+#include <emmintrin.h>
+#endif
+
 namespace boardgame {
 
-// std::vector<std::array<unsigned, 3>> NineMenMorris::kMills = {
-// 	{ 0, 1, 2 },
-// 	{ 0, 9, 21 },
-// 	{ 2, 14, 23 },
-// 	{ 21, 22, 23 },
-// 	{ 3, 4, 5 },
-// 	{ 3, 10, 18 },
-// 	{ 18, 19, 20 },
-// 	{ 5, 13, 20 },
-// 	{ 6, 7, 8 },
-// 	{ 6, 11, 15 },
-// 	{ 8, 12, 17 },
-// 	{ 15, 16, 17 },
-// 	{ 9, 10, 11 },
-// 	{ 1, 4, 7 },
-// 	{ 16, 19, 22 },
-// 	{ 12, 13, 14 }
-// };
-
-std::vector<std::array<unsigned, 2>> NineMenMorris::kMills = {
-    { 1, 2 }, { 9, 21 },
-    { 0, 2 }, { 4, 7 },
-    { 0, 1 }, { 14, 23 },
-    { 4, 5 }, { 10, 18 },
-    { 3, 5 }, { 1, 7 },
-    { 13, 20 }, { 3, 4 },
-    { 7, 8 }, { 11, 15 },
-    { 6, 8 },  { 1, 4 },
-    { 12, 17 }, { 6, 7 },
-    { 10, 11 }, { 0, 21 },
-    { 9, 11 }, { 3, 18 },
-    { 9, 10 }, { 6, 15 },
-    { 13, 14 }, { 8, 17 },
-    { 12, 14 }, { 5, 20 },
-    { 12, 13}, { 2, 23 },
-    { 16, 17 }, { 6, 11 },
-    { 19, 22 }, { 15, 17 },
-    { 15, 16 }, { 8, 12 },
-    { 19, 20 }, { 3, 10 },
-    { 18, 20 }, { 16, 22 },
-    { 18, 19 }, { 5, 13 },
-    { 22, 23 }, { 0, 9 },
-    { 21, 23 }, { 16, 19 },
-    { 21, 22 }, { 2, 14 }
-};
-
-std::vector<std::vector<unsigned>> NineMenMorris::kNeighbors = {
-    { 1, 9 },
-    { 0, 2, 4 },
-    { 1, 14 },
-    { 4, 10 },
-    { 3, 5, 1, 7 },
-    { 4, 13 },
-    { 11, 7 },
-    { 4, 6, 8 },
-    { 7, 12 },
-    { 0, 21, 10 },
-    { 3, 9, 18, 11 },
-    { 6, 10, 15 },
-    { 8, 17, 13 },
-    { 5, 12, 20, 14 },
-    { 2, 13, 23 },
-    { 11, 16 },
-    { 15, 17, 19 },
-    { 12, 16 },
-    { 10, 19 },
-    { 16, 18, 22, 20 },
-    { 13, 19 },
-    { 9, 22 },
-    { 19, 21, 23 },
-    { 14, 22 }
-};
-
-NineMenMorrisState::Phase NineMenMorris::GetStage(NineMenMorrisState const & state, Player player) {
+template<class Board>
+const std::array<std::array<std::uint64_t, 2>, Board::kBoardSize> Morris<Board>::kZobrist = [] {
+    std::array<std::array<std::uint64_t, 2>, Board::kBoardSize> keys;
+    std::uint64_t seed = 0x4e696e654d656e4dULL;
+    for (auto & spot_keys : keys) {
+        for (auto & key : spot_keys) {
+            key = utility::SplitMix64(seed);
+        }
+    }
+    return keys;
+}();
+
+template<class Board>
+std::uint64_t Morris<Board>::BoardHash(MorrisState<Board> const & state) {
+    std::uint64_t hash = 0;
+    for (unsigned i = 0; i < state.board.size(); ++i) {
+        if (state.board[i] != Player::kNone) {
+            hash ^= kZobrist[i][static_cast<unsigned>(state.board[i])];
+        }
+    }
+    return hash;
+}
+
+template<class Board>
+std::uint64_t Morris<Board>::BoardHash(MorrisState<Board> const & state, unsigned symmetry) {
+    std::uint64_t hash = 0;
+    for (unsigned i = 0; i < state.board.size(); ++i) {
+        if (state.board[i] != Player::kNone) {
+            hash ^= kZobrist[kSymmetries[symmetry][i]][static_cast<unsigned>(state.board[i])];
+        }
+    }
+    return hash;
+}
+
+template<class Board>
+std::uint64_t Morris<Board>::RestHash(MorrisState<Board> const & state) {
+    std::uint64_t rest = static_cast<std::uint64_t>(state.player)
+        | static_cast<std::uint64_t>(state.RemainingToPlay(Player::kLeftPlayer)) << 2
+        | static_cast<std::uint64_t>(state.RemainingToPlay(Player::kRightPlayer)) << 8
+        | static_cast<std::uint64_t>(state.PliesWithoutMill()) << 14;
+    rest ^= state.HistoryHash() << 24;
+    return utility::SplitMix64(rest);
+}
+
+template<class Board>
+std::uint64_t Morris<Board>::Hash(MorrisState<Board> const & state) {
+    return state.Hash() ^ RestHash(state);
+}
+
+template<class Board>
+MorrisState<Board> Morris<Board>::Transform(MorrisState<Board> const & state, unsigned symmetry) {
+    MorrisState<Board> next_state(state);
+    for (unsigned i = 0; i < state.board.size(); ++i) {
+        next_state.board[kSymmetries[symmetry][i]] = state.board[i];
+    }
+    next_state.SetHash(BoardHash(next_state));
+    return next_state;
+}
+
+template<class Board>
+unsigned Morris<Board>::CanonicalSymmetry(MorrisState<Board> const & state, std::uint64_t & board_hash) {
+    board_hash = state.Hash();
+    if (state.CanRepeat()) return 0;
+
+    unsigned best = 0;
+    for (unsigned symmetry = 1; symmetry < kSymmetryCount; ++symmetry) {
+        std::uint64_t hash = BoardHash(state, symmetry);
+        if (hash < board_hash) {
+            board_hash = hash;
+            best = symmetry;
+        }
+    }
+    return best;
+}
+
+template<class Board>
+std::tuple<MorrisState<Board>, unsigned> Morris<Board>::Canonical(MorrisState<Board> const & state) {
+    std::uint64_t board_hash;
+    unsigned symmetry = CanonicalSymmetry(state, board_hash);
+    return { symmetry == 0 ? state : Transform(state, symmetry), symmetry };
+}
+
+template<class Board>
+std::uint64_t Morris<Board>::CanonicalHash(MorrisState<Board> const & state) {
+    std::uint64_t board_hash;
+    CanonicalSymmetry(state, board_hash);
+    return board_hash ^ RestHash(state);
+}
+
+template<class Board>
+double Morris<Board>::MovePrior(MorrisState<Board> const & state, MorrisMove const & move) {
+    if (move.deletion != -1) return 4.0;
+    Player opponent = Opponent(state.player);
+    if (Threatens(state, Pieces(state, opponent), move.destination, opponent)) return 2.0;
+    return 1.0;
+}
+
+template<class Board>
+unsigned Morris<Board>::MovesToGo(MorrisState<Board> const & state) {
+    // the placement decides most games, so what comes after it counts as a few moves
+    switch (state.Stage(state.player)) {
+        case MorrisPhase::kPlacement: return state.RemainingToPlay(state.player) + 12;
+        case MorrisPhase::kMovement: return 12;
+        default: return 6;
+    }
+}
+
+template<class Board>
+void Morris<Board>::EncodeFeatures(MorrisState<Board> const & state, float * features) {
+    Player opponent = Opponent(state.player);
+    for (unsigned i = 0; i < Board::kBoardSize; ++i) {
+        features[i] = state.board[i] == state.player ? 1.0f : 0.0f;
+        features[Board::kBoardSize + i] = state.board[i] == opponent ? 1.0f : 0.0f;
+    }
+
+    float * counts = features + 2 * Board::kBoardSize;
+    counts[0] = state.RemainingToPlay(state.player) / static_cast<float>(Board::kPieceCount);
+    counts[1] = state.RemainingToPlay(opponent) / static_cast<float>(Board::kPieceCount);
+    counts[2] = state.Remaining(state.player) / static_cast<float>(Board::kPieceCount);
+    counts[3] = state.Remaining(opponent) / static_cast<float>(Board::kPieceCount);
+}
+
+template<class Board>
+MorrisPhase Morris<Board>::GetStage(MorrisState<Board> const & state, Player player) {
     // in free move stage
-    if (state.Stage(player) == NineMenMorrisState::Phase::kMovement && state.Remaining(player) <= 3) {
-        return NineMenMorrisState::Phase::kFreeMovement;
+    if (state.Stage(player) == MorrisPhase::kMovement && state.Remaining(player) <= 3) {
+        return MorrisPhase::kFreeMovement;
     }
     // in moving stage
     else if (state.RemainingToPlay(player) == 0) {
-        return NineMenMorrisState::Phase::kMovement;
+        return MorrisPhase::kMovement;
     }
     // in placing stage
     else {
-        return NineMenMorrisState::Phase::kPlacement;
+        return MorrisPhase::kPlacement;
     }
 }
 
-bool NineMenMorris::PartOfAMill(NineMenMorrisState const & state, unsigned destination, Player player) {
-    unsigned index = destination * 2;
-    return (state.board[kMills[index][0]] == player && state.board[kMills[index][1]] == player) ||
-        (state.board[kMills[index + 1][0]] == player && state.board[kMills[index + 1][1]] == player);
+template<class Board>
+std::uint32_t Morris<Board>::Pieces(MorrisState<Board> const & state, Player player) {
+    std::uint32_t pieces = 0;
+#ifdef MORRIS_PIECES_SSE2
+    static_assert(sizeof(Player) == 4 && Board::kBoardSize % 4 == 0, "the spots are compared four at a time");
+    __m128i players = _mm_set1_epi32(static_cast<int>(player));
+    for (unsigned i = 0; i < Board::kBoardSize; i += 4) {
+        __m128i spots = _mm_loadu_si128(reinterpret_cast<__m128i const *>(state.board.data() + i));
+        pieces |= static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(spots, players)))) << i;
+    }
+#else
+    for (unsigned i = Board::kBoardSize; i-- > 0;) {
+        pieces = (pieces << 1) | static_cast<std::uint32_t>(state.board[i] == player);
+    }
+#endif
+    return pieces;
 }
 
-NineMenMorrisState NineMenMorris::ApplyMove(NineMenMorrisState const & state, NineMenMorrisMove const & move) {
-    NineMenMorrisState next_state(state);
+template<class Board>
+std::uint32_t Morris<Board>::MillSpots(std::uint32_t pieces) {
+    std::uint32_t spots = 0;
+    for (auto mask : kMillMasks) {
+        spots |= (pieces & mask) == mask ? mask : 0;
+    }
+    return spots;
+}
+
+template<class Board>
+std::uint32_t Morris<Board>::RemovablePieces(MorrisState<Board> const & state) {
+    // can only remove opponent's piece if it is not already part of a mill
+    std::uint32_t opponent_pieces = Pieces(state, Opponent(state.player));
+    return opponent_pieces & ~MillSpots(opponent_pieces);
+}
+
+template<class Board>
+bool Morris<Board>::ClosesMill(std::uint32_t pieces, int source, int destination) {
+    // the source spot is empty after the move so it cannot be part of the new mill
+    std::uint32_t owned = pieces | (std::uint32_t(1) << destination);
+    if (source != -1) owned &= ~(std::uint32_t(1) << source);
+
+    return AnyMillThrough(destination, owned);
+}
+
+template<class Board>
+int Morris<Board>::NthCell(MorrisState<Board> const & state, Player player, unsigned n) {
+    for (unsigned i = 0; i < state.board.size(); ++i) {
+        if (state.board[i] == player && n-- == 0) return i;
+    }
+    return -1;
+}
+
+template<class Board>
+unsigned Morris<Board>::MovePairs(MorrisState<Board> const & state, MovePairArray & pairs) {
+    unsigned count = 0;
+    switch (state.Stage(state.player)) {
+        case MorrisPhase::kFreeMovement:
+            for (unsigned i = 0; i < state.board.size(); ++i) {
+                if (state.board[i] != state.player) continue;
+                for (unsigned j = 0; j < state.board.size(); ++j) {
+                    if (state.board[j] == Player::kNone) pairs[count++] = { static_cast<int>(i), static_cast<int>(j) };
+                }
+            }
+            break;
+        case MorrisPhase::kMovement:
+            for (unsigned i = 0; i < state.board.size(); ++i) {
+                if (state.board[i] != state.player) continue;
+                for (auto neighbor : kNeighbors[i]) {
+                    if (state.board[neighbor] == Player::kNone) pairs[count++] = { static_cast<int>(i), static_cast<int>(neighbor) };
+                }
+            }
+            break;
+        default:
+            for (unsigned i = 0; i < state.board.size(); ++i) {
+                if (state.board[i] == Player::kNone) pairs[count++] = { -1, static_cast<int>(i) };
+            }
+            break;
+    }
+    return count;
+}
+
+template<class Board>
+bool Morris<Board>::Threatens(MorrisState<Board> const & state, std::uint32_t pieces, unsigned spot, Player player) {
+    if (state.board[spot] != Player::kNone) return false;
+
+    switch (state.Stage(player)) {
+        case MorrisPhase::kFreeMovement:
+            for (unsigned i = 0; i < state.board.size(); ++i) {
+                if ((pieces >> i) & 1 && ClosesMill(pieces, i, spot)) return true;
+            }
+            return false;
+        case MorrisPhase::kMovement:
+            for (auto neighbor : kNeighbors[spot]) {
+                if ((pieces >> neighbor) & 1 && ClosesMill(pieces, neighbor, spot)) return true;
+            }
+            return false;
+        default:
+            return ClosesMill(pieces, -1, spot);
+    }
+}
+
+template<class Board>
+MorrisState<Board> Morris<Board>::ApplyMove(MorrisState<Board> const & state, MorrisMove const & move) {
+    MorrisState<Board> next_state(state);
 
     next_state.player = Opponent(state.player);
 
+    unsigned player_index = static_cast<unsigned>(state.player);
+    std::uint64_t hash = state.Hash();
+
     // moving the piece from source position
     if (move.source != -1) {
         next_state.board[move.source] = Player::kNone;
+        hash ^= kZobrist[move.source][player_index];
     }
     // the piece is a new piece
     else {
@@ -113,11 +268,23 @@ NineMenMorrisState NineMenMorris::ApplyMove(NineMenMorrisState const & state, Ni
 
     // place the piece at the destination position
     next_state.board[move.destination] = state.player;
+    hash ^= kZobrist[move.destination][player_index];
 
     // if the move is removing opponent's piece at deletion position
     if (move.deletion != -1) {
         next_state.board[move.deletion] = Player::kNone;
         next_state.SetRemaining(next_state.player, next_state.Remaining(next_state.player) - 1);
+        hash ^= kZobrist[move.deletion][static_cast<unsigned>(next_state.player)];
+    }
+
+    // a removal resets the draw counter, and placements and removals cannot be undone
+    // so the earlier positions cannot repeat anymore
+    next_state.SetHash(hash);
+    next_state.SetPliesWithoutMill(move.deletion != -1 ? 0 : state.PliesWithoutMill() + 1);
+    if (move.source == -1 || move.deletion != -1) {
+        next_state.ClearPositions();
+    } else {
+        next_state.RecordPosition(state.Hash());
     }
 
     next_state.SetStage(state.player, GetStage(next_state, state.player));
@@ -126,22 +293,19 @@ NineMenMorrisState NineMenMorris::ApplyMove(NineMenMorrisState const & state, Ni
     return next_state;
 }
 
-void NineMenMorris::DeletionMoves(NineMenMorrisState const & state, int source, int destination, std::vector<NineMenMorrisMove> & moves) {
-    auto move_without_deletion = NineMenMorrisMove(source, destination, -1);
-    auto next_state = ApplyMove(state, move_without_deletion);
+template<class Board>
+void Morris<Board>::DeletionMoves(std::uint32_t pieces, std::uint32_t removable, int source, int destination, std::vector<MorrisMove> & moves) {
+    auto move_without_deletion = MorrisMove(source, destination, -1);
 
     // if the move forms a mill, then find all possible opponent's pieces that can be removed
-    bool forms_a_mill = PartOfAMill(next_state, destination, state.player);
+    bool forms_a_mill = ClosesMill(pieces, source, destination);
     if (forms_a_mill) {
         bool found_deletion_moves = false;
 
-        for (unsigned i = 0; i < next_state.board.size(); ++i) {
-            if (next_state.board[i] == next_state.player) {
-                // can only remove opponent's piece if it is not already part of a mill
-                if (!PartOfAMill(next_state, i, next_state.player)) {
-                    moves.emplace_back(source, destination, i);
-                    found_deletion_moves = true;
-                }
+        for (unsigned i = 0; i < Board::kBoardSize; ++i) {
+            if ((removable >> i) & 1) {
+                moves.emplace_back(source, destination, i);
+                found_deletion_moves = true;
             }
         }
 
@@ -155,29 +319,37 @@ void NineMenMorris::DeletionMoves(NineMenMorrisState const & state, int source,
     }
 }
 
-std::vector<NineMenMorrisMove> NineMenMorris::PlacementMoves(NineMenMorrisState const & state) {
-    std::vector<NineMenMorrisMove> moves;
+template<class Board>
+std::vector<MorrisMove> Morris<Board>::PlacementMoves(MorrisState<Board> const & state) {
+    std::vector<MorrisMove> moves;
     moves.reserve(64);
 
+    std::uint32_t pieces = Pieces(state, state.player);
+    std::uint32_t removable = RemovablePieces(state);
+
     // find an empty spot on the board
     for (unsigned i = 0; i < state.board.size(); ++i) {
         if (state.board[i] == Player::kNone) {
-            DeletionMoves(state, -1, i, moves);
+            DeletionMoves(pieces, removable, -1, i, moves);
         }
     }
     return moves;
 }
 
-std::vector<NineMenMorrisMove> NineMenMorris::MovementMoves(NineMenMorrisState const & state) {
-    std::vector<NineMenMorrisMove> moves;
+template<class Board>
+std::vector<MorrisMove> Morris<Board>::MovementMoves(MorrisState<Board> const & state) {
+    std::vector<MorrisMove> moves;
     moves.reserve(64);
 
+    std::uint32_t pieces = Pieces(state, state.player);
+    std::uint32_t removable = RemovablePieces(state);
+
     // get all moves from player pieces to available neighbor spot
     for (unsigned i = 0; i < state.board.size(); ++i) {
         if (state.board[i] == state.player) {
             for (auto & neighbor : kNeighbors[i]) {
                 if (state.board[neighbor] == Player::kNone) {
-                    DeletionMoves(state, i, neighbor, moves);
+                    DeletionMoves(pieces, removable, i, neighbor, moves);
                 }
             }
         }
@@ -185,16 +357,20 @@ std::vector<NineMenMorrisMove> NineMenMorris::MovementMoves(NineMenMorrisState c
     return moves;
 }
 
-std::vector<NineMenMorrisMove> NineMenMorris::FreeMovementMoves(NineMenMorrisState const & state) {
-    std::vector<NineMenMorrisMove> moves;
+template<class Board>
+std::vector<MorrisMove> Morris<Board>::FreeMovementMoves(MorrisState<Board> const & state) {
+    std::vector<MorrisMove> moves;
     moves.reserve(64);
 
+    std::uint32_t pieces = Pieces(state, state.player);
+    std::uint32_t removable = RemovablePieces(state);
+
     // get all moves from all player pieces to available empty spots
     for (unsigned i = 0; i < state.board.size(); ++i) {
         if (state.board[i] == state.player) {
             for (unsigned j = 0; j < state.board.size(); ++j) {
                 if (state.board[j] == Player::kNone) {
-                    DeletionMoves(state, i, j, moves);
+                    DeletionMoves(pieces, removable, i, j, moves);
                 }
             }
         }
@@ -203,16 +379,18 @@ std::vector<NineMenMorrisMove> NineMenMorris::FreeMovementMoves(NineMenMorrisSta
     return moves;
 }
 
-std::vector<NineMenMorrisMove> NineMenMorris::ListMoves(NineMenMorrisState const & state) {
+template<class Board>
+std::vector<MorrisMove> Morris<Board>::ListMoves(MorrisState<Board> const & state) {
     auto player_stage = state.Stage(state.player);
     switch (player_stage) {
-        case NineMenMorrisState::Phase::kFreeMovement: return FreeMovementMoves(state);
-        case NineMenMorrisState::Phase::kMovement: return MovementMoves(state);
+        case MorrisPhase::kFreeMovement: return FreeMovementMoves(state);
+        case MorrisPhase::kMovement: return MovementMoves(state);
         default: return PlacementMoves(state);
     }
 }
 
-std::tuple<bool, Player> NineMenMorris::Winner(NineMenMorrisState const & state) {
+template<class Board>
+std::tuple<bool, Player> Morris<Board>::Winner(MorrisState<Board> const & state) {
     // if there are less than three pieces left for either player
     if (state.Remaining(Player::kLeftPlayer) < 3) {
         return { false, Player::kRightPlayer };
@@ -220,8 +398,14 @@ std::tuple<bool, Player> NineMenMorris::Winner(NineMenMorrisState const & state)
         return { false, Player::kLeftPlayer };
     }
 
+    // draw by too many moves without a mill or by repeating a position
+    // repetitions are only detected in cycles of at most 4 plies, see MorrisState::kPositionHistorySize
+    if (state.PliesWithoutMill() >= kMaxPliesWithoutMill || state.Repetitions() >= kMaxRepetitions) {
+        return { false, Player::kNone };
+    }
+
     // secondary win conditions
-    if (state.Stage(state.player) == NineMenMorrisState::Phase::kMovement) {
+    if (state.Stage(state.player) == MorrisPhase::kMovement) {
 
         // check if there is an available move left for the current player
         for (unsigned i = 0; i < state.board.size(); ++i) {
@@ -233,6 +417,13 @@ std::tuple<bool, Player> NineMenMorris::Winner(NineMenMorrisState const & state)
                 }
             }
         }
+        // a board filled during placement leaves nobody a move, which is a draw
+        if constexpr (2 * Board::kPieceCount >= Board::kBoardSize) {
+            if (std::find(state.board.begin(), state.board.end(), Player::kNone) == state.board.end()) {
+                return { false, Player::kNone };
+            }
+        }
+
         // no more moves available for the current player, so the opponent wins
         return { false, Opponent(state.player) };
     }
@@ -241,7 +432,8 @@ std::tuple<bool, Player> NineMenMorris::Winner(NineMenMorrisState const & state)
     return kOnGoingGame;
 }
 
-std::tuple<bool, std::array<double, 2>> NineMenMorris::StateValue(NineMenMorrisState const & state, unsigned /*depth*/) {
+template<class Board>
+std::tuple<bool, std::array<double, 2>> Morris<Board>::StateValue(MorrisState<Board> const & state, unsigned /*depth*/) {
     auto [on_going, winner] = Winner(state);
 
     if (winner == Player::kLeftPlayer) return { false, {1.0, 0.0} };
@@ -251,14 +443,34 @@ std::tuple<bool, std::array<double, 2>> NineMenMorris::StateValue(NineMenMorrisS
     return {on_going, {0.5, 0.5}};
 }
 
-NineMenMorrisState NineMenMorris::SimulationPolicy(NineMenMorrisState const & state, std::mt19937_64 & random_engine) {
-    auto moves = ListMoves(state);
+template<class Board>
+std::array<double, 2> Morris<Board>::Evaluate(MorrisState<Board> const & state) {
+    double left = state.Remaining(Player::kLeftPlayer);
+    double right = state.Remaining(Player::kRightPlayer);
 
-    std::uniform_int_distribution<std::size_t> moves_distribution(0, moves.size() - 1);
-
-    auto best_move = moves[moves_distribution(random_engine)];
+    // 0.5 when even, moving towards a win for whoever has more pieces left
+    double left_value = 0.5 + 0.5 * (left - right) / (left + right);
+    return { left_value, 1.0 - left_value };
+}
 
-    return ApplyMove(state, best_move);
+template<class Board>
+void Morris<Board>::BatchSimulate(std::vector<MorrisState<Board>> const & states, std::uint64_t seed, std::vector<std::array<double, 2>> & values) {
+    utility::Xoshiro256PlusPlus random_engine(seed);
+
+    values.resize(states.size());
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        MorrisState<Board> state = states[i];
+        auto result = StateValue(state);
+        while (std::get<0>(result)) {
+            state = SimulationPolicy(state, random_engine);
+            result = StateValue(state);
+        }
+        values[i] = std::get<1>(result);
+    }
 }
 
+template class Morris<SixMenMorrisBoard>;
+template class Morris<NineMenMorrisBoard>;
+template class Morris<TwelveMenMorrisBoard>;
+
 } // namespace boardgame
@@ -2,11 +2,13 @@
 #define MORRIS_GAMES_NINE_MEN_MORRIS_HPP_
 
 #include "simulation.hpp"
+#include "batch.hpp"
+#include "../utility/random.hpp"
 
 namespace boardgame {
 
-struct NineMenMorrisMove {
-    NineMenMorrisMove(int source, int destination, int deletion) :
+struct MorrisMove {
+    MorrisMove(int source, int destination, int deletion) :
         source(source), destination(destination), deletion(deletion) {}
 
     int source = -1;
@@ -14,16 +16,198 @@ struct NineMenMorrisMove {
     int deletion = -1;
 };
 
-struct NineMenMorrisState {
-    static const unsigned kBoardSize = 24;
+enum class MorrisPhase {
+    kPlacement,
+    kMovement,
+    kFreeMovement
+};
+
+// the spots next to a spot, at most four of them
+struct MorrisNeighbors {
+    unsigned count;
+    std::array<unsigned, 4> spots;
+
+    constexpr unsigned const * begin() const {
+        return spots.data();
+    }
+
+    constexpr unsigned const * end() const {
+        return spots.data() + count;
+    }
+};
+
+// where a spot lies, the rings from the outside in and the places around a ring clockwise
+// from the top left corner, corners are even and the middles of the sides odd
+struct MorrisPlace {
+    unsigned ring;
+    unsigned place;
+};
+
+// one bit per spot of every mill through a spot
+template<unsigned MaxMills>
+struct MorrisSpotMills {
+    unsigned count;
+    std::array<std::uint32_t, MaxMills> masks;
+
+    constexpr std::uint32_t const * begin() const {
+        return masks.data();
+    }
+
+    constexpr std::uint32_t const * end() const {
+        return masks.data() + count;
+    }
+};
+
+// the boards of the morris games, a board is the number of spots, the pieces every player
+// starts with, the three spots of every mill, the spots next to every spot and where every
+// spot lies on the rings, the spots are numbered row by row from the top left
+
+// two squares with a mill along every side, the middles of the sides are joined but form no mill
+struct SixMenMorrisBoard {
+    static constexpr unsigned kBoardSize = 16;
+    static constexpr unsigned kPieceCount = 6;
+
+    static constexpr std::array<std::array<unsigned, 3>, 8> kMillLines = {{
+        { 0, 1, 2 }, { 3, 4, 5 }, { 10, 11, 12 }, { 13, 14, 15 },
+        { 0, 6, 13 }, { 3, 7, 10 }, { 5, 8, 12 }, { 2, 9, 15 }
+    }};
+
+    static constexpr std::array<MorrisNeighbors, kBoardSize> kNeighbors = {{
+        { 2, { 1, 6 } },
+        { 3, { 0, 2, 4 } },
+        { 2, { 1, 9 } },
+        { 2, { 4, 7 } },
+        { 3, { 1, 3, 5 } },
+        { 2, { 4, 8 } },
+        { 3, { 0, 7, 13 } },
+        { 3, { 3, 6, 10 } },
+        { 3, { 5, 9, 12 } },
+        { 3, { 2, 8, 15 } },
+        { 2, { 7, 11 } },
+        { 3, { 10, 12, 14 } },
+        { 2, { 8, 11 } },
+        { 2, { 6, 14 } },
+        { 3, { 11, 13, 15 } },
+        { 2, { 9, 14 } }
+    }};
+
+    static constexpr unsigned kRingCount = 2;
+    static constexpr std::array<MorrisPlace, kBoardSize> kPlaces = {{
+        { 0, 0 }, { 0, 1 }, { 0, 2 },
+        { 1, 0 }, { 1, 1 }, { 1, 2 },
+        { 0, 7 }, { 1, 7 }, { 1, 3 }, { 0, 3 },
+        { 1, 6 }, { 1, 5 }, { 1, 4 },
+        { 0, 6 }, { 0, 5 }, { 0, 4 }
+    }};
+};
+
+// three squares with a mill along every side and across the middles of the sides
+struct NineMenMorrisBoard {
+    static constexpr unsigned kBoardSize = 24;
+    static constexpr unsigned kPieceCount = 9;
 
-    enum class Phase {
-        kPlacement,
-        kMovement,
-        kFreeMovement
-    };
+    static constexpr std::array<std::array<unsigned, 3>, 16> kMillLines = {{
+        { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 }, { 9, 10, 11 },
+        { 12, 13, 14 }, { 15, 16, 17 }, { 18, 19, 20 }, { 21, 22, 23 },
+        { 0, 9, 21 }, { 3, 10, 18 }, { 6, 11, 15 }, { 1, 4, 7 },
+        { 16, 19, 22 }, { 8, 12, 17 }, { 5, 13, 20 }, { 2, 14, 23 }
+    }};
 
-    NineMenMorrisState(Player player) : player(player) {
+    static constexpr std::array<MorrisNeighbors, kBoardSize> kNeighbors = {{
+        { 2, { 1, 9 } },
+        { 3, { 0, 2, 4 } },
+        { 2, { 1, 14 } },
+        { 2, { 4, 10 } },
+        { 4, { 3, 5, 1, 7 } },
+        { 2, { 4, 13 } },
+        { 2, { 11, 7 } },
+        { 3, { 4, 6, 8 } },
+        { 2, { 7, 12 } },
+        { 3, { 0, 21, 10 } },
+        { 4, { 3, 9, 18, 11 } },
+        { 3, { 6, 10, 15 } },
+        { 3, { 8, 17, 13 } },
+        { 4, { 5, 12, 20, 14 } },
+        { 3, { 2, 13, 23 } },
+        { 2, { 11, 16 } },
+        { 3, { 15, 17, 19 } },
+        { 2, { 12, 16 } },
+        { 2, { 10, 19 } },
+        { 4, { 16, 18, 22, 20 } },
+        { 2, { 13, 19 } },
+        { 2, { 9, 22 } },
+        { 3, { 19, 21, 23 } },
+        { 2, { 14, 22 } }
+    }};
+
+    static constexpr unsigned kRingCount = 3;
+    static constexpr std::array<MorrisPlace, kBoardSize> kPlaces = {{
+        { 0, 0 }, { 0, 1 }, { 0, 2 },
+        { 1, 0 }, { 1, 1 }, { 1, 2 },
+        { 2, 0 }, { 2, 1 }, { 2, 2 },
+        { 0, 7 }, { 1, 7 }, { 2, 7 }, { 2, 3 }, { 1, 3 }, { 0, 3 },
+        { 2, 6 }, { 2, 5 }, { 2, 4 },
+        { 1, 6 }, { 1, 5 }, { 1, 4 },
+        { 0, 6 }, { 0, 5 }, { 0, 4 }
+    }};
+};
+
+// the nine men's morris board with the corners of the squares joined by diagonals that form mills too
+struct TwelveMenMorrisBoard {
+    static constexpr unsigned kBoardSize = 24;
+    static constexpr unsigned kPieceCount = 12;
+
+    static constexpr std::array<std::array<unsigned, 3>, 20> kMillLines = {{
+        { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 }, { 9, 10, 11 },
+        { 12, 13, 14 }, { 15, 16, 17 }, { 18, 19, 20 }, { 21, 22, 23 },
+        { 0, 9, 21 }, { 3, 10, 18 }, { 6, 11, 15 }, { 1, 4, 7 },
+        { 16, 19, 22 }, { 8, 12, 17 }, { 5, 13, 20 }, { 2, 14, 23 },
+        { 0, 3, 6 }, { 2, 5, 8 }, { 15, 18, 21 }, { 17, 20, 23 }
+    }};
+
+    static constexpr std::array<MorrisNeighbors, kBoardSize> kNeighbors = {{
+        { 3, { 1, 9, 3 } },
+        { 3, { 0, 2, 4 } },
+        { 3, { 1, 14, 5 } },
+        { 4, { 4, 10, 0, 6 } },
+        { 4, { 3, 5, 1, 7 } },
+        { 4, { 4, 13, 2, 8 } },
+        { 3, { 11, 7, 3 } },
+        { 3, { 4, 6, 8 } },
+        { 3, { 7, 12, 5 } },
+        { 3, { 0, 21, 10 } },
+        { 4, { 3, 9, 18, 11 } },
+        { 3, { 6, 10, 15 } },
+        { 3, { 8, 17, 13 } },
+        { 4, { 5, 12, 20, 14 } },
+        { 3, { 2, 13, 23 } },
+        { 3, { 11, 16, 18 } },
+        { 3, { 15, 17, 19 } },
+        { 3, { 12, 16, 20 } },
+        { 4, { 10, 19, 15, 21 } },
+        { 4, { 16, 18, 22, 20 } },
+        { 4, { 13, 19, 17, 23 } },
+        { 3, { 9, 22, 18 } },
+        { 3, { 19, 21, 23 } },
+        { 3, { 14, 22, 20 } }
+    }};
+
+    static constexpr unsigned kRingCount = 3;
+    static constexpr std::array<MorrisPlace, kBoardSize> kPlaces = NineMenMorrisBoard::kPlaces;
+};
+
+template<class Board>
+struct MorrisState {
+    static const unsigned kBoardSize = Board::kBoardSize;
+
+    // number of earlier positions remembered for the repetition rule
+    // a third occurrence is only seen for cycles of at most 4 plies, longer ones are left to the
+    // rule of plies without a mill, which keeps the states small for the searches that copy them
+    static constexpr unsigned kPositionHistorySize = 8;
+
+    using Phase = MorrisPhase;
+
+    MorrisState(Player player) : player(player) {
         std::fill(board.begin(), board.end(), Player::kNone);
     }
 
@@ -51,6 +235,58 @@ struct NineMenMorrisState {
         phase_[static_cast<unsigned>(player)] = phase;
     }
 
+    // zobrist hash of the board, kept up to date by Morris::ApplyMove
+    std::uint64_t Hash() const {
+        return hash_;
+    }
+
+    void SetHash(std::uint64_t hash) {
+        hash_ = hash;
+    }
+
+    unsigned PliesWithoutMill() const {
+        return plies_without_mill_;
+    }
+
+    void SetPliesWithoutMill(unsigned plies_without_mill) {
+        plies_without_mill_ = plies_without_mill;
+    }
+
+    // remember a position that can still repeat, the most recent one first
+    void RecordPosition(std::uint64_t hash) {
+        std::copy_backward(position_history_.begin(), position_history_.end() - 1, position_history_.end());
+        position_history_[0] = static_cast<std::uint32_t>(hash);
+        position_history_size_ = std::min(position_history_size_ + 1, kPositionHistorySize);
+    }
+
+    // after a placement or a removal no earlier position can come back
+    void ClearPositions() {
+        position_history_size_ = 0;
+    }
+
+    // whether an earlier position can still come back
+    bool CanRepeat() const {
+        return position_history_size_ > 0;
+    }
+
+    // hash of the remembered positions, states with the same board can still end differently
+    std::uint64_t HistoryHash() const {
+        std::uint64_t hash = position_history_size_;
+        for (unsigned i = 0; i < position_history_size_; ++i) {
+            hash = (hash ^ position_history_[i]) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    // how many remembered positions equal the current one with the same player to move
+    unsigned Repetitions() const {
+        unsigned repetitions = 0;
+        for (unsigned i = 1; i < position_history_size_; i += 2) {
+            repetitions += position_history_[i] == static_cast<std::uint32_t>(hash_);
+        }
+        return repetitions;
+    }
+
     void Print() const {
         for (unsigned i = 0; i < board.size(); ++i) {
             std::cout << static_cast<int>(board[i]) << ", ";
@@ -59,38 +295,527 @@ struct NineMenMorrisState {
         std::cout << "Phase: " << static_cast<int>(phase_[0]) << ", " << static_cast<int>(phase_[1]) << '\n';
     }
 
+    // the hash is left out, it follows from the board and states set up by hand do not keep it
+    bool operator==(MorrisState const & other) const {
+        return player == other.player && board == other.board &&
+            remaining_to_play_ == other.remaining_to_play_ && remaining_ == other.remaining_ && phase_ == other.phase_ &&
+            plies_without_mill_ == other.plies_without_mill_ && position_history_size_ == other.position_history_size_ &&
+            std::equal(position_history_.begin(), position_history_.begin() + position_history_size_, other.position_history_.begin());
+    }
+
     Player player = Player::kLeftPlayer;
     std::array<Player, kBoardSize> board;
 private:
-    std::array<unsigned, 2> remaining_to_play_ = { 9, 9 };
-    std::array<unsigned, 2> remaining_ = { 9, 9 };
+    std::array<unsigned, 2> remaining_to_play_ = { Board::kPieceCount, Board::kPieceCount };
+    std::array<unsigned, 2> remaining_ = { Board::kPieceCount, Board::kPieceCount };
     std::array<Phase, 2> phase_ = { Phase::kPlacement, Phase::kPlacement };
+    std::uint64_t hash_ = 0;
+    unsigned plies_without_mill_ = 0;
+    unsigned position_history_size_ = 0;
+    std::array<std::uint32_t, kPositionHistorySize> position_history_ = {};
 };
 
-class NineMenMorris {
+// the tables of Morris are built from the board when compiling
+namespace morris_tables {
+
+template<std::size_t MillCount>
+using MillLines = std::array<std::array<unsigned, 3>, MillCount>;
+
+template<unsigned BoardSize>
+using Neighbors = std::array<MorrisNeighbors, BoardSize>;
+
+template<unsigned BoardSize, unsigned MaxMills>
+using SpotMills = std::array<MorrisSpotMills<MaxMills>, BoardSize>;
+
+// the most mills through one spot
+template<unsigned BoardSize, std::size_t MillCount>
+constexpr unsigned MaxMillsPerSpot(MillLines<MillCount> const & lines) {
+    std::array<unsigned, BoardSize> found {};
+    unsigned most = 0;
+    for (auto const & line : lines) {
+        for (unsigned spot : line) {
+            found[spot] += 1;
+            most = std::max(most, found[spot]);
+        }
+    }
+    return most;
+}
+
+// one bit for every spot of the board
+constexpr std::uint32_t AllSpots(unsigned board_size) {
+    return board_size == 32 ? ~std::uint32_t(0) : (std::uint32_t(1) << board_size) - 1;
+}
+
+// one bit per spot of every mill
+template<std::size_t MillCount>
+constexpr std::array<std::uint32_t, MillCount> MillMasks(MillLines<MillCount> const & lines) {
+    std::array<std::uint32_t, MillCount> masks {};
+    for (unsigned i = 0; i < lines.size(); ++i) {
+        for (unsigned spot : lines[i]) {
+            masks[i] |= std::uint32_t(1) << spot;
+        }
+    }
+    return masks;
+}
+
+// for every spot the masks of the mills through it
+template<unsigned BoardSize, unsigned MaxMills, std::size_t MillCount>
+constexpr SpotMills<BoardSize, MaxMills> MillsBySpot(MillLines<MillCount> const & lines) {
+    SpotMills<BoardSize, MaxMills> mills {};
+    auto masks = MillMasks(lines);
+    for (unsigned i = 0; i < lines.size(); ++i) {
+        for (unsigned spot : lines[i]) {
+            auto & spot_mills = mills[spot];
+            spot_mills.masks[spot_mills.count++] = masks[i];
+        }
+    }
+    return mills;
+}
+
+// every spot lies on a mill and every mill has three different spots
+template<unsigned BoardSize, std::size_t MillCount>
+constexpr bool MillsCoverTheBoard(std::array<std::uint32_t, MillCount> const & masks) {
+    std::uint32_t covered = 0;
+    for (auto mask : masks) {
+        unsigned spots = 0;
+        for (unsigned spot = 0; spot < BoardSize; ++spot) {
+            spots += (mask >> spot) & 1;
+        }
+        if (spots != 3) return false;
+        covered |= mask;
+    }
+    return covered == AllSpots(BoardSize);
+}
+
+// whether every spot lies on the same number of mills
+template<unsigned BoardSize, unsigned MaxMills>
+constexpr bool EqualMillsPerSpot(SpotMills<BoardSize, MaxMills> const & mills) {
+    for (auto const & spot_mills : mills) {
+        if (spot_mills.count != MaxMills) return false;
+    }
+    return true;
+}
+
+template<unsigned BoardSize>
+constexpr bool NeighborsAreSymmetric(Neighbors<BoardSize> const & neighbors) {
+    for (unsigned spot = 0; spot < neighbors.size(); ++spot) {
+        for (unsigned neighbor : neighbors[spot]) {
+            bool back = false;
+            for (unsigned other : neighbors[neighbor]) {
+                back = back || other == spot;
+            }
+            if (!back) return false;
+        }
+    }
+    return true;
+}
+
+// symmetries[s][i] is the spot that spot i goes to under symmetry s
+template<unsigned BoardSize>
+using Symmetries = std::array<std::array<unsigned, BoardSize>, 16>;
+
+// the eight rotations and reflections of the square, each with and without turning the rings
+// inside out, symmetry s reflects left to right when s % 8 >= 4, then turns s % 4 quarters
+// clockwise and swaps the rings when s >= 8
+template<unsigned BoardSize>
+constexpr Symmetries<BoardSize> MakeSymmetries(std::array<MorrisPlace, BoardSize> const & places, unsigned ring_count) {
+    Symmetries<BoardSize> symmetries {};
+    for (unsigned s = 0; s < symmetries.size(); ++s) {
+        for (unsigned spot = 0; spot < BoardSize; ++spot) {
+            unsigned place = s % 8 >= 4 ? (10 - places[spot].place) % 8 : places[spot].place;
+            place = (place + 2 * (s % 4)) % 8;
+            unsigned ring = s >= 8 ? ring_count - 1 - places[spot].ring : places[spot].ring;
+            for (unsigned other = 0; other < BoardSize; ++other) {
+                if (places[other].ring == ring && places[other].place == place) symmetries[s][spot] = other;
+            }
+        }
+    }
+    return symmetries;
+}
+
+// the symmetry that undoes every symmetry
+template<unsigned BoardSize>
+constexpr std::array<unsigned, 16> InverseSymmetries(Symmetries<BoardSize> const & symmetries) {
+    std::array<unsigned, 16> inverses {};
+    for (unsigned s = 0; s < symmetries.size(); ++s) {
+        for (unsigned t = 0; t < symmetries.size(); ++t) {
+            bool undoes = true;
+            for (unsigned spot = 0; spot < BoardSize; ++spot) {
+                undoes = undoes && symmetries[t][symmetries[s][spot]] == spot;
+            }
+            if (undoes) inverses[s] = t;
+        }
+    }
+    return inverses;
+}
+
+// every symmetry moves the spots onto all the spots, the mills onto mills and neighbors onto neighbors
+template<unsigned BoardSize, std::size_t MillCount>
+constexpr bool SymmetriesKeepTheBoard(Symmetries<BoardSize> const & symmetries,
+                                      std::array<std::uint32_t, MillCount> const & masks, Neighbors<BoardSize> const & neighbors) {
+    for (auto const & symmetry : symmetries) {
+        std::uint32_t image = 0;
+        for (unsigned spot : symmetry) {
+            image |= std::uint32_t(1) << spot;
+        }
+        if (image != AllSpots(BoardSize)) return false;
+
+        for (auto mask : masks) {
+            std::uint32_t moved = 0;
+            for (unsigned spot = 0; spot < BoardSize; ++spot) {
+                if ((mask >> spot) & 1) moved |= std::uint32_t(1) << symmetry[spot];
+            }
+            bool found = false;
+            for (auto other : masks) {
+                found = found || other == moved;
+            }
+            if (!found) return false;
+        }
+
+        for (unsigned spot = 0; spot < BoardSize; ++spot) {
+            for (unsigned neighbor : neighbors[spot]) {
+                bool found = false;
+                for (unsigned other : neighbors[symmetry[spot]]) {
+                    found = found || other == symmetry[neighbor];
+                }
+                if (!found) return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace morris_tables
+
+// the morris games on the board Board, every board has its own tables and its own code
+// with all the sizes known when compiling, the rules are the same on every board
+template<class Board>
+class Morris {
 public:
+    using StateType = MorrisState<Board>;
+
+    static_assert(Board::kBoardSize <= 32, "the mill masks have one bit per spot");
+
     const unsigned kMaxMillsSizePerPlayer = 4;
 
-    static std::tuple<bool, Player> Winner(NineMenMorrisState const & state);
-    static std::tuple<bool, std::array<double, 2>> StateValue(NineMenMorrisState const & state, unsigned depth = 0);
-    static NineMenMorrisState SimulationPolicy(NineMenMorrisState const & state, std::mt19937_64 & random_engine);
-
-    static NineMenMorrisState::Phase GetStage(NineMenMorrisState const & state, Player player);
-    static std::vector<NineMenMorrisMove> ListMoves(NineMenMorrisState const & state);
-    static NineMenMorrisState ApplyMove(NineMenMorrisState const & state, NineMenMorrisMove const & move);
-    static std::vector<NineMenMorrisMove> PlacementMoves(NineMenMorrisState const & state);
-    static std::vector<NineMenMorrisMove> MovementMoves(NineMenMorrisState const & state);
-    static std::vector<NineMenMorrisMove> FreeMovementMoves(NineMenMorrisState const & state);
-    static void DeletionMoves(NineMenMorrisState const & state, int source, int destination, std::vector<NineMenMorrisMove> & moves);
-    static bool PartOfAMill(NineMenMorrisState const & state, unsigned destination, Player player);
+    // moves are numbered by MoveIndex from 0 to kMoveIndexCount - 1
+    // the index covers the source and destination, the deletion is left out
+    static const unsigned kMoveIndexCount = (Board::kBoardSize + 1) * Board::kBoardSize;
+
+    // most {source, destination} pairs a state can have, flying with 3 pieces to the empty spots,
+    // placing on an empty board or moving every piece to four neighbors
+    static constexpr unsigned kMaxMovePairs = std::max({ 3 * (Board::kBoardSize - 3), Board::kBoardSize, 4 * Board::kPieceCount });
+    using MovePairArray = std::array<std::array<int, 2>, kMaxMovePairs>;
+
+    // most moves a state can have, every pair closing a mill while the opponent still has all
+    // its pieces to remove
+    static const unsigned kMaxBranchingFactor = kMaxMovePairs * Board::kPieceCount;
+
+    // the game is a draw after this many plies without removing a piece
+    static const unsigned kMaxPliesWithoutMill = 100;
+
+    // the game is a draw when the same position is reached for the third time
+    static const unsigned kMaxRepetitions = 2;
+
+    static std::tuple<bool, Player> Winner(StateType const & state);
+    static std::tuple<bool, std::array<double, 2>> StateValue(StateType const & state, unsigned depth = 0);
+
+    // value of a game that was not played to the end, based on the remaining pieces
+    static std::array<double, 2> Evaluate(StateType const & state);
+
+    // zobrist hash of the board computed from scratch
+    static std::uint64_t BoardHash(StateType const & state);
+
+    // key of the whole position, the board hash mixed with everything else that decides
+    // the moves and the outcome: player to move, pieces to place, draw counter and history
+    static std::uint64_t Hash(StateType const & state);
+
+    // the rotations and reflections of the board, each with the rings turned inside out or not
+    static const unsigned kSymmetryCount = 16;
+
+    // the state with the board turned by the symmetry, symmetry 0 leaves it as it is
+    // the remembered positions of the repetition rule cannot be turned and stay as they are
+    static StateType Transform(StateType const & state, unsigned symmetry);
+
+    static MorrisMove TransformMove(MorrisMove const & move, unsigned symmetry) {
+        auto transform = [symmetry](int spot) {
+            return spot == -1 ? -1 : static_cast<int>(kSymmetries[symmetry][spot]);
+        };
+        return MorrisMove(transform(move.source), transform(move.destination), transform(move.deletion));
+    }
+
+    // the symmetry that turns the board back
+    static unsigned InverseSymmetry(unsigned symmetry) {
+        return kInverseSymmetries[symmetry];
+    }
+
+    // the symmetric state with the lowest board hash and the symmetry that turns state into it
+    // a state that can still repeat a remembered position is its own canonical form
+    static std::tuple<StateType, unsigned> Canonical(StateType const & state);
+
+    // Hash of the canonical form, the same for all symmetric states
+    static std::uint64_t CanonicalHash(StateType const & state);
+
+    // inputs of a network, a plane of the cells of the player to move and one of the opponent,
+    // then the pieces both still have to place and have left, as fractions of the starting pieces
+    static const unsigned kFeatureCount = 2 * Board::kBoardSize + 4;
+    static void EncodeFeatures(StateType const & state, float * features);
+
+    // draws a random legal move without listing all the moves
+    // the source and destination are uniform over the legal pairs, and only when the move
+    // closes a mill a removable opponent piece is drawn uniformly as well
+    template<class RandomEngineType>
+    static MorrisMove RandomMove(StateType const & state, RandomEngineType & random_engine) {
+        int source = -1;
+        int destination = -1;
+
+        switch (state.Stage(state.player)) {
+            case MorrisPhase::kFreeMovement: {
+                // every piece can fly to every empty spot, so piece and spot are independent
+                unsigned piece_count = 0;
+                unsigned empty_count = 0;
+                for (auto player : state.board) {
+                    piece_count += player == state.player;
+                    empty_count += player == Player::kNone;
+                }
+                source = NthCell(state, state.player, utility::Bounded(random_engine, piece_count));
+                destination = NthCell(state, Player::kNone, utility::Bounded(random_engine, empty_count));
+                break;
+            }
+            case MorrisPhase::kMovement: {
+                unsigned pair_count = 0;
+                for (unsigned i = 0; i < state.board.size(); ++i) {
+                    if (state.board[i] != state.player) continue;
+                    for (auto neighbor : kNeighbors[i]) {
+                        pair_count += state.board[neighbor] == Player::kNone;
+                    }
+                }
+
+                unsigned k = utility::Bounded(random_engine, pair_count);
+                for (unsigned i = 0; i < state.board.size() && destination == -1; ++i) {
+                    if (state.board[i] != state.player) continue;
+                    for (auto neighbor : kNeighbors[i]) {
+                        if (state.board[neighbor] == Player::kNone && k-- == 0) {
+                            source = i;
+                            destination = neighbor;
+                            break;
+                        }
+                    }
+                }
+                break;
+            }
+            default: {
+                unsigned empty_count = 0;
+                for (auto player : state.board) {
+                    empty_count += player == Player::kNone;
+                }
+                destination = NthCell(state, Player::kNone, utility::Bounded(random_engine, empty_count));
+                break;
+            }
+        }
+
+        int deletion = ClosesMill(Pieces(state, state.player), source, destination) ? RandomDeletion(state, random_engine) : -1;
+        return MorrisMove(source, destination, deletion);
+    }
+
+    // a uniform random opponent piece that is not part of a mill, or -1 when there is none
+    template<class RandomEngineType>
+    static int RandomDeletion(StateType const & state, RandomEngineType & random_engine) {
+        std::uint32_t removable = RemovablePieces(state);
+        unsigned removable_count = 0;
+        for (std::uint32_t bits = removable; bits != 0; bits &= bits - 1) {
+            removable_count += 1;
+        }
+        if (removable_count == 0) return -1;
+
+        unsigned k = utility::Bounded(random_engine, removable_count);
+        for (unsigned i = 0; i < state.board.size(); ++i) {
+            if ((removable >> i) & 1 && k-- == 0) return i;
+        }
+        return -1;
+    }
+
+    // informed rollout move, in order of preference:
+    // close a mill, block a spot where the opponent would close a mill,
+    // any move that does not open a mill for the opponent, and a random move otherwise
+    template<class RandomEngineType>
+    static MorrisMove HeavyMove(StateType const & state, RandomEngineType & random_engine) {
+        Player opponent = Opponent(state.player);
+
+        MovePairArray pairs;
+        unsigned pair_count = MovePairs(state, pairs);
+        if (pair_count == 0) return RandomMove(state, random_engine);
+
+        // moves without a deletion leave the pieces of the opponent where they are
+        std::uint32_t pieces = Pieces(state, state.player);
+        std::uint32_t opponent_pieces = Pieces(state, opponent);
+
+        // moves of the most preferred category that has any
+        MovePairArray candidates;
+        unsigned candidate_count = 0;
+
+        for (unsigned i = 0; i < pair_count; ++i) {
+            if (ClosesMill(pieces, pairs[i][0], pairs[i][1])) candidates[candidate_count++] = pairs[i];
+        }
+        if (candidate_count > 0) {
+            auto pair = candidates[utility::Bounded(random_engine, candidate_count)];
+            return MorrisMove(pair[0], pair[1], RandomDeletion(state, random_engine));
+        }
+
+        for (unsigned i = 0; i < pair_count; ++i) {
+            if (Threatens(state, opponent_pieces, pairs[i][1], opponent)) candidates[candidate_count++] = pairs[i];
+        }
+
+        if (candidate_count == 0) {
+            for (unsigned i = 0; i < pair_count; ++i) {
+                if (pairs[i][0] == -1) {
+                    candidates[candidate_count++] = pairs[i];
+                    continue;
+                }
+
+                // the spot the piece leaves must not let the opponent close a mill
+                auto next_state = ApplyMove(state, MorrisMove(pairs[i][0], pairs[i][1], -1));
+                if (!Threatens(next_state, opponent_pieces, pairs[i][0], opponent)) candidates[candidate_count++] = pairs[i];
+            }
+        }
+
+        if (candidate_count == 0) return RandomMove(state, random_engine);
+
+        auto pair = candidates[utility::Bounded(random_engine, candidate_count)];
+        return MorrisMove(pair[0], pair[1], -1);
+    }
+
+    // weight of a move for the search to try it first, moves that close a mill before moves that
+    // take a spot where the opponent would close one before the rest
+    static double MovePrior(StateType const & state, MorrisMove const & move);
+
+    // moves the player to move is expected to still play, which the time manager spreads the clock over
+    static unsigned MovesToGo(StateType const & state);
+
+    template<class RandomEngineType>
+    static StateType SimulationPolicy(StateType const & state, RandomEngineType & random_engine) {
+        return ApplyMove(state, RandomMove(state, random_engine));
+    }
+
+    // play every state to the end with uniform random moves
+    // the rules do not fit lockstep lanes, so each playout runs on its own
+    static void BatchSimulate(std::vector<StateType> const & states, std::uint64_t seed, std::vector<std::array<double, 2>> & values);
+
+    static MorrisPhase GetStage(StateType const & state, Player player);
+    static std::vector<MorrisMove> ListMoves(StateType const & state);
+    static StateType ApplyMove(StateType const & state, MorrisMove const & move);
+
+    static unsigned MoveIndex(MorrisMove const & move) {
+        return (move.source + 1) * Board::kBoardSize + move.destination;
+    }
+
+    // small number that stands for the move in a game record, placements without a mill stay below 128
+    // so they take one byte as a varint and every other move two
+    static std::uint16_t EncodeMove(MorrisMove const & move) {
+        return static_cast<std::uint16_t>(MoveIndex(move) + (move.deletion + 1) * kMoveIndexCount);
+    }
+    static MorrisMove DecodeMove(std::uint16_t code) {
+        unsigned index = code % kMoveIndexCount;
+        return MorrisMove(
+            static_cast<int>(index / Board::kBoardSize) - 1,
+            static_cast<int>(index % Board::kBoardSize),
+            static_cast<int>(code / kMoveIndexCount) - 1);
+    }
+    static std::vector<MorrisMove> PlacementMoves(StateType const & state);
+    static std::vector<MorrisMove> MovementMoves(StateType const & state);
+    static std::vector<MorrisMove> FreeMovementMoves(StateType const & state);
+
+    // the move from source to destination with every deletion it allows, pieces are the ones of the
+    // player to move and removable the opponent pieces it may take
+    static void DeletionMoves(std::uint32_t pieces, std::uint32_t removable, int source, int destination, std::vector<MorrisMove> & moves);
+
+    // one bit per spot that holds a piece of player
+    static std::uint32_t Pieces(StateType const & state, Player player);
+
+    // the pieces that are part of a mill
+    static std::uint32_t MillSpots(std::uint32_t pieces);
+
+    // the pieces of the opponent that the player to move may remove, the ones outside of mills
+    static std::uint32_t RemovablePieces(StateType const & state);
+
+    // whether moving one of pieces from source (-1 for a new piece) to destination forms a mill
+    static bool ClosesMill(std::uint32_t pieces, int source, int destination);
+
+    // index of the n-th cell that holds player, or -1
+    static int NthCell(StateType const & state, Player player, unsigned n);
+
+    // all legal {source, destination} pairs of the player to move without the deletions
+    static unsigned MovePairs(StateType const & state, MovePairArray & pairs);
+
+    // whether player, who holds pieces, could close a mill on the empty spot with its next move
+    static bool Threatens(StateType const & state, std::uint32_t pieces, unsigned spot, Player player);
+
+    // the three spots of every mill
+    static constexpr auto kMillLines = Board::kMillLines;
+
+    // one bit per spot of every mill
+    static constexpr auto kMillMasks = morris_tables::MillMasks(kMillLines);
+
+    // the most mills through one spot, two on the boards without diagonals
+    static constexpr unsigned kMaxMillsPerSpot = morris_tables::MaxMillsPerSpot<Board::kBoardSize>(kMillLines);
+
 private:
-    // indices to all possible mill combinations
-    static std::vector<std::array<unsigned, 2>> kMills;
+    // the masks of the mills through every spot
+    static constexpr auto kMills = morris_tables::MillsBySpot<Board::kBoardSize, kMaxMillsPerSpot>(kMillLines);
+
+    // when every spot lies on as many mills the loops over them have a fixed length
+    static constexpr bool kEqualMillsPerSpot = morris_tables::EqualMillsPerSpot<Board::kBoardSize, kMaxMillsPerSpot>(kMills);
 
     // all the possible moves from one spot to another
-    static std::vector<std::vector<unsigned>> kNeighbors;
+    static constexpr auto kNeighbors = Board::kNeighbors;
+
+    // whether owned holds all three spots of a mill through spot
+    static bool AnyMillThrough(unsigned spot, std::uint32_t owned) {
+        auto const & mills = kMills[spot];
+        unsigned count = kEqualMillsPerSpot ? kMaxMillsPerSpot : mills.count;
+        bool found = false;
+        for (unsigned k = 0; k < count; ++k) {
+            found |= (owned & mills.masks[k]) == mills.masks[k];
+        }
+        return found;
+    }
+
+    static constexpr auto kSymmetries = morris_tables::MakeSymmetries<Board::kBoardSize>(Board::kPlaces, Board::kRingCount);
+    static constexpr auto kInverseSymmetries = morris_tables::InverseSymmetries<Board::kBoardSize>(kSymmetries);
+
+    static_assert(morris_tables::MillsCoverTheBoard<Board::kBoardSize>(kMillMasks), "every spot lies on a mill of three spots");
+    static_assert(morris_tables::NeighborsAreSymmetric<Board::kBoardSize>(kNeighbors), "spots are neighbors of their neighbors");
+    static_assert(morris_tables::SymmetriesKeepTheBoard<Board::kBoardSize>(kSymmetries, kMillMasks, kNeighbors),
+        "the rotations, reflections and ring swaps keep the mills and the neighbors");
+
+    // the zobrist hash of the board turned by the symmetry
+    static std::uint64_t BoardHash(StateType const & state, unsigned symmetry);
+
+    // the symmetry that gives the lowest board hash, which it stores in board_hash
+    static unsigned CanonicalSymmetry(StateType const & state, std::uint64_t & board_hash);
+
+    // the hash of everything but the board
+    static std::uint64_t RestHash(StateType const & state);
+
+    // random keys of every player's piece on every spot
+    static const std::array<std::array<std::uint64_t, 2>, Board::kBoardSize> kZobrist;
 };
 
+// the code of every board is compiled once in nine_men_morris.cpp
+extern template class Morris<SixMenMorrisBoard>;
+extern template class Morris<NineMenMorrisBoard>;
+extern template class Morris<TwelveMenMorrisBoard>;
+
+using SixMenMorrisState = MorrisState<SixMenMorrisBoard>;
+using SixMenMorris = Morris<SixMenMorrisBoard>;
+
+using NineMenMorrisMove = MorrisMove;
+using NineMenMorrisState = MorrisState<NineMenMorrisBoard>;
+using NineMenMorris = Morris<NineMenMorrisBoard>;
+
+using TwelveMenMorrisState = MorrisState<TwelveMenMorrisBoard>;
+using TwelveMenMorris = Morris<TwelveMenMorrisBoard>;
+
 } // namespace boardgame
 
 #endif /* MORRIS_GAMES_NINE_MEN_MORRIS_HPP_ */
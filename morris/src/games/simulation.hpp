@@ -1,6 +1,8 @@
 #ifndef simulation_hpp
 #define simulation_hpp
 
+#include "../utility/trace.hpp"
+
 namespace boardgame {
 
 enum class Player {
@@ -20,6 +22,13 @@ static Player RandomPlayer() {
     return (std::rand() % 2) == 0 ? Player::kLeftPlayer : Player::kRightPlayer;
 }
 
+// whether an algorithm can play on a game clock
+template<class T, class = void>
+struct HasSetClock : std::false_type {};
+
+template<class T>
+struct HasSetClock<T, std::void_t<decltype(std::declval<T &>().SetClock(0ll, 0ll))>> : std::true_type {};
+
 template<class GameType, class StateType, class MoveType, class LAlgorithmType, class RAlgorithmType>
 class Simulation {
 public:
@@ -35,6 +44,22 @@ public:
     void Initialize(StateType initial_state) {
         state_ = initial_state;
         history_ = std::vector<StateType> { state_ };
+        remaining_time_.fill(clock_time_);
+    }
+
+    // both players get time_in_milliseconds for the game and increment_in_milliseconds more after
+    // every move they pick, from the next Initialize on, 0 plays without a clock
+    // algorithms with a SetClock are told their time before every move, and whoever
+    // runs out of time loses, moves passed to Move(move) are not timed
+    void SetClock(long long time_in_milliseconds, long long increment_in_milliseconds) {
+        clock_time_ = time_in_milliseconds;
+        clock_increment_ = increment_in_milliseconds;
+        remaining_time_.fill(clock_time_);
+    }
+
+    // milliseconds left on the clock of the player, below 0 once it ran out
+    long long RemainingTime(Player player) const {
+        return remaining_time_[static_cast<unsigned>(player)];
     }
 
     Player Run() {
@@ -44,17 +69,39 @@ public:
     }
 
     std::tuple<bool, Player> Move(MoveType const & move) {
-        state_ = GameType::ApplyMove(state_, move);
-        history_.push_back(state_);
-        return GameType::Winner(state_);
+        return Play(GameType::ApplyMove(state_, move));
     }
 
     std::tuple<bool, Player> Move() {
+        MORRIS_TRACE_SCOPE("simulation move");
 
         // given the current state, play a move and get a new state
-        state_ = state_.player == Player::kLeftPlayer ? l_algorithm_.Compute(state_) : r_algorithm_.Compute(state_);
+        return Play(NextState(state_));
+    }
+
+    // the state the algorithm of the player to move picks, without playing it
+    // the search can run on another thread as long as nothing else uses that algorithm meanwhile
+    StateType NextState(StateType const & state) {
+        MORRIS_TRACE_SCOPE("simulation next state");
+        if (clock_time_ <= 0) {
+            return state.player == Player::kLeftPlayer ? l_algorithm_.Compute(state) : r_algorithm_.Compute(state);
+        }
+
+        auto & remaining_time = remaining_time_[static_cast<unsigned>(state.player)];
+        auto start = std::chrono::steady_clock::now();
+        StateType next_state = state.player == Player::kLeftPlayer ? TimedCompute(l_algorithm_, state) : TimedCompute(r_algorithm_, state);
+        remaining_time -= std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        if (remaining_time >= 0) remaining_time += clock_increment_;
+        return next_state;
+    }
+
+    // play a state picked by NextState
+    std::tuple<bool, Player> Play(StateType const & next_state) {
+        if (move_listener_) move_listener_(state_, next_state);
+        Player mover = state_.player;
+        state_ = next_state;
         history_.push_back(state_);
-        //state_.Print();
+        if (clock_time_ > 0 && RemainingTime(mover) < 0) return std::make_tuple(false, Opponent(mover));
         return GameType::Winner(state_);
     }
 
@@ -62,14 +109,46 @@ public:
         return history_.size();
     }
 
+    // every state of the game so far, the first one is the initial state
+    std::vector<StateType> const & History() const {
+        return history_;
+    }
+
     StateType State() {
         return state_;
     }
+
+    // called with the state before and after every move played, for example to record the game
+    void SetMoveListener(std::function<void(StateType const &, StateType const &)> move_listener) {
+        move_listener_ = std::move(move_listener);
+    }
+
+    // the algorithms playing each side, for example to read their statistics
+    LAlgorithmType & LeftAlgorithm() {
+        return l_algorithm_;
+    }
+
+    RAlgorithmType & RightAlgorithm() {
+        return r_algorithm_;
+    }
 private:
+    template<class AlgorithmType>
+    StateType TimedCompute(AlgorithmType & algorithm, StateType const & state) {
+        if constexpr (HasSetClock<AlgorithmType>::value) {
+            algorithm.SetClock(RemainingTime(state.player), clock_increment_);
+        }
+        return algorithm.Compute(state);
+    }
+
     StateType state_;
     LAlgorithmType l_algorithm_;
     RAlgorithmType r_algorithm_;
     std::vector<StateType> history_;
+    std::function<void(StateType const &, StateType const &)> move_listener_;
+
+    long long clock_time_ = 0;
+    long long clock_increment_ = 0;
+    std::array<long long, 2> remaining_time_ = {};
 };
 
 } // namespace boardgame
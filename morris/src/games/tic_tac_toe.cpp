@@ -14,6 +14,19 @@ const std::array<std::array<int, 3>, 8> TicTacToe::kWinCombos = { {
     {6, 4, 2}
 } };
 
+const std::array<std::array<int, TicTacToeState::kBoardSize>, TicTacToe::kSymmetryCount> TicTacToe::kSymmetries = { {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8},
+    {2, 5, 8, 1, 4, 7, 0, 3, 6},
+    {8, 7, 6, 5, 4, 3, 2, 1, 0},
+    {6, 3, 0, 7, 4, 1, 8, 5, 2},
+    {2, 1, 0, 5, 4, 3, 8, 7, 6},
+    {8, 5, 2, 7, 4, 1, 6, 3, 0},
+    {6, 7, 8, 3, 4, 5, 0, 1, 2},
+    {0, 3, 6, 1, 4, 7, 2, 5, 8}
+} };
+
+const std::array<unsigned, TicTacToe::kSymmetryCount> TicTacToe::kInverseSymmetries = { 0, 3, 2, 1, 4, 5, 6, 7 };
+
 std::tuple<bool, Player> TicTacToe::Winner(TicTacToeState const &state) {
 
     for (unsigned i = 0; i < TicTacToe::kWinCombos.size(); ++i) {
@@ -53,6 +66,97 @@ std::tuple<bool, std::array<double, 2>> TicTacToe::StateValue(TicTacToeState con
     return { on_going, {0.5, 0.5} };
 }
 
+unsigned TicTacToe::CompletingCells(TicTacToeState const &state, Player player, std::array<int, TicTacToeState::kBoardSize> &cells) {
+    std::array<bool, TicTacToeState::kBoardSize> found = {};
+    unsigned count = 0;
+
+    for (auto const & combo : kWinCombos) {
+        int empty = -1;
+        unsigned owned = 0;
+        for (int i : combo) {
+            if (state.board[i] == player) ++owned;
+            else if (state.board[i] == Player::kNone) empty = i;
+        }
+
+        // two pieces of the player and the third spot is still empty
+        if (owned == 2 && empty != -1 && !found[empty]) {
+            found[empty] = true;
+            cells[count++] = empty;
+        }
+    }
+    return count;
+}
+
+std::array<double, 2> TicTacToe::Evaluate(TicTacToeState const &/*state*/) {
+    return { 0.5, 0.5 };
+}
+
+std::uint64_t TicTacToe::Hash(TicTacToeState const &state) {
+    return SymmetricHash(state, 0);
+}
+
+std::uint64_t TicTacToe::SymmetricHash(TicTacToeState const &state, unsigned symmetry) {
+    std::uint64_t hash = static_cast<std::uint64_t>(state.player) << (2 * TicTacToeState::kBoardSize);
+    for (unsigned i = 0; i < TicTacToeState::kBoardSize; ++i) {
+        if (state.board[i] != Player::kNone) {
+            hash |= std::uint64_t(1) << (kSymmetries[symmetry][i] + TicTacToeState::kBoardSize * static_cast<unsigned>(state.board[i]));
+        }
+    }
+    return hash;
+}
+
+TicTacToeState TicTacToe::Transform(TicTacToeState const &state, unsigned symmetry) {
+    TicTacToeState next_state(state.player);
+    for (unsigned i = 0; i < TicTacToeState::kBoardSize; ++i) {
+        next_state.board[kSymmetries[symmetry][i]] = state.board[i];
+    }
+    return next_state;
+}
+
+std::tuple<TicTacToeState, unsigned> TicTacToe::Canonical(TicTacToeState const &state) {
+    unsigned best = 0;
+    std::uint64_t best_hash = Hash(state);
+    for (unsigned symmetry = 1; symmetry < kSymmetryCount; ++symmetry) {
+        std::uint64_t hash = SymmetricHash(state, symmetry);
+        if (hash < best_hash) {
+            best_hash = hash;
+            best = symmetry;
+        }
+    }
+    return { Transform(state, best), best };
+}
+
+std::uint64_t TicTacToe::CanonicalHash(TicTacToeState const &state) {
+    std::uint64_t best_hash = Hash(state);
+    for (unsigned symmetry = 1; symmetry < kSymmetryCount; ++symmetry) {
+        best_hash = std::min(best_hash, SymmetricHash(state, symmetry));
+    }
+    return best_hash;
+}
+
+double TicTacToe::MovePrior(TicTacToeState const &state, TicTacToeMove const &move) {
+    std::array<int, TicTacToeState::kBoardSize> cells;
+    std::array<double, 2> weights = { 4.0, 2.0 };
+    std::array<Player, 2> players = { state.player, Opponent(state.player) };
+    for (unsigned i = 0; i < players.size(); ++i) {
+        unsigned count = CompletingCells(state, players[i], cells);
+        if (std::find(cells.begin(), cells.begin() + count, move.destination) != cells.begin() + count) return weights[i];
+    }
+    return 1.0;
+}
+
+unsigned TicTacToe::MovesToGo(TicTacToeState const &state) {
+    auto empty = static_cast<unsigned>(std::count(state.board.begin(), state.board.end(), Player::kNone));
+    return (empty + 1) / 2;
+}
+
+void TicTacToe::EncodeFeatures(TicTacToeState const &state, float *features) {
+    for (unsigned i = 0; i < TicTacToeState::kBoardSize; ++i) {
+        features[i] = state.board[i] == state.player ? 1.0f : 0.0f;
+        features[TicTacToeState::kBoardSize + i] = state.board[i] == Opponent(state.player) ? 1.0f : 0.0f;
+    }
+}
+
 TicTacToeState TicTacToe::ApplyMove(TicTacToeState const &state, TicTacToeMove const &move) {
     TicTacToeState next_state(state);
     next_state.player = Opponent(state.player);
@@ -70,12 +174,188 @@ std::vector<TicTacToeMove> TicTacToe::ListMoves(TicTacToeState const &state) {
     return moves;
 }
 
-TicTacToeState TicTacToe::SimulationPolicy(TicTacToeState const &state, std::mt19937_64 &random_engine) {
-    auto moves = ListMoves(state);
-    std::uniform_int_distribution<std::size_t> moves_distribution(0, moves.size() - 1);
-    return ApplyMove(state, moves[moves_distribution(random_engine)]);
-}
+void TicTacToe::BatchSimulate(std::vector<TicTacToeState> const &states, std::uint64_t seed, std::vector<std::array<double, 2>> &values) {
+    const std::uint32_t kFullBoard = (1u << TicTacToeState::kBoardSize) - 1;
+    const std::uint32_t kNone = static_cast<std::uint32_t>(Player::kNone);
 
-} // namespace boardgame
+    std::array<std::uint32_t, 8> win_masks;
+    for (unsigned i = 0; i < kWinCombos.size(); ++i) {
+        win_masks[i] = (1u << kWinCombos[i][0]) | (1u << kWinCombos[i][1]) | (1u << kWinCombos[i][2]);
+    }
+    auto has_line = [&win_masks](std::uint32_t pieces) {
+        for (auto win_mask : win_masks) {
+            if ((pieces & win_mask) == win_mask) return true;
+        }
+        return false;
+    };
+
+    // the states that go on as pieces of the player to move and of its opponent, in the order the lanes
+    // take them, and the winner of each once it is played out
+    // the vector kernel reads a register past the last one, the padding keeps that in bounds
+    std::vector<std::uint32_t> owns, others, players, origins, results(states.size(), kNone);
+    values.resize(states.size());
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        auto const & state = states[i];
+        std::uint32_t own = 0, other = 0;
+        for (unsigned cell = 0; cell < TicTacToeState::kBoardSize; ++cell) {
+            if (state.board[cell] == state.player) own |= 1u << cell;
+            else if (state.board[cell] != Player::kNone) other |= 1u << cell;
+        }
+
+        if (has_line(other)) results[i] = static_cast<std::uint32_t>(Opponent(state.player));
+        else if (has_line(own)) results[i] = static_cast<std::uint32_t>(state.player);
+        else if ((own | other) != kFullBoard) {
+            owns.push_back(own);
+            others.push_back(other);
+            players.push_back(static_cast<std::uint32_t>(state.player));
+            origins.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    std::uint32_t count = static_cast<std::uint32_t>(owns.size());
+    for (auto * lanes : { &owns, &others, &players }) {
+        lanes->resize(count + 2 * kBatchLanes);
+    }
+    std::vector<std::uint32_t> outcomes(count);
+
+    LaneRandom<std::uint32_t> random(seed);
+    if (count > 0) {
+#ifdef MORRIS_BATCH_AVX2
+        using namespace batch_avx2;
+        const __m256i full = _mm256_set1_epi32(static_cast<int>(kFullBoard));
+        const __m256i none = _mm256_set1_epi32(static_cast<int>(kNone));
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i total = _mm256_set1_epi32(static_cast<int>(count));
+
+        // two registers of 8 lanes, the lanes of the second follow the ones of the first
+        __m256i own[2], other[2], player[2], index[2], active[2], state[2];
+        std::uint32_t next = 0;
+        for (unsigned half = 0; half < 2; ++half, next += 8) {
+            own[half] = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(owns.data() + next));
+            other[half] = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(others.data() + next));
+            player[half] = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(players.data() + next));
+            index[half] = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(next)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            active[half] = _mm256_cmpgt_epi32(total, index[half]);
+            state[half] = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(random.State().data() + 8 * half));
+        }
+
+        for (;;) {
+            unsigned finished[2];
+            __m256i result[2];
+            for (unsigned half = 0; half < 2; ++half) {
+                __m256i empty = _mm256_andnot_si256(_mm256_or_si256(own[half], other[half]), full);
+                __m256i draw = Bounded32(state[half], PopCount32(empty));
+
+                // clear the lowest empty cell while fewer than draw are cleared, then keep the lowest one left
+                __m256i cells = empty;
+                for (int cleared = 0; cleared + 1 < static_cast<int>(TicTacToeState::kBoardSize); ++cleared) {
+                    __m256i clear = _mm256_cmpgt_epi32(draw, _mm256_set1_epi32(cleared));
+                    cells = _mm256_andnot_si256(_mm256_andnot_si256(_mm256_sub_epi32(cells, one), clear), cells);
+                }
+                __m256i placed = _mm256_or_si256(own[half], _mm256_and_si256(cells, _mm256_sub_epi32(_mm256_setzero_si256(), cells)));
+
+                __m256i won = _mm256_setzero_si256();
+                for (auto win_mask : win_masks) {
+                    __m256i line = _mm256_set1_epi32(static_cast<int>(win_mask));
+                    won = _mm256_or_si256(won, _mm256_cmpeq_epi32(_mm256_and_si256(placed, line), line));
+                }
+                __m256i ended = _mm256_or_si256(won, _mm256_cmpeq_epi32(_mm256_or_si256(placed, other[half]), full));
+
+                finished[half] = LaneMask32(_mm256_and_si256(active[half], ended));
+                result[half] = _mm256_blendv_epi8(none, player[half], won);
+                own[half] = other[half];
+                other[half] = placed;
+                player[half] = _mm256_xor_si256(player[half], one);
+            }
+            if ((finished[0] | finished[1]) == 0) continue;
 
+            // the finished lanes hand in their winner and take the next states in lane order
+            for (unsigned half = 0; half < 2; ++half) {
+                if (finished[half] == 0) continue;
 
+                alignas(32) std::array<std::uint32_t, 8> indices, winners;
+                _mm256_store_si256(reinterpret_cast<__m256i *>(indices.data()), index[half]);
+                _mm256_store_si256(reinterpret_cast<__m256i *>(winners.data()), result[half]);
+                std::uint32_t taken = 0;
+                for (unsigned lane = 0; lane < 8; ++lane) {
+                    if ((finished[half] >> lane & 1) == 0) continue;
+                    outcomes[indices[lane]] = winners[lane];
+                    taken += 1;
+                }
+
+                own[half] = Expand32(own[half], finished[half], owns.data() + next);
+                other[half] = Expand32(other[half], finished[half], others.data() + next);
+                player[half] = Expand32(player[half], finished[half], players.data() + next);
+                index[half] = ExpandIndices32(index[half], finished[half], next);
+                active[half] = _mm256_cmpgt_epi32(total, index[half]);
+                next += taken;
+            }
+            if ((LaneMask32(active[0]) | LaneMask32(active[1])) == 0) break;
+        }
+#else
+        Lanes<std::uint32_t> own, other, player, index, active;
+        std::uint32_t next = 0;
+
+        // a lane takes the next state that goes on, once they are all taken it idles
+        auto load = [&](unsigned lane) {
+            active[lane] = next < count;
+            if (!active[lane]) return;
+            own[lane] = owns[next];
+            other[lane] = others[next];
+            player[lane] = players[next];
+            index[lane] = next++;
+        };
+        for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+            load(lane);
+        }
+
+        Lanes<std::uint32_t> empty, counts, draws, picked, placed, won, finished, result;
+        while (LaneBits(active) != 0) {
+
+            // pick one of the empty cells of every lane uniformly, idle lanes play on without being read
+            for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+                empty[lane] = ~(own[lane] | other[lane]) & kFullBoard;
+            }
+            PopCount(empty, counts);
+            random.Bounded(counts, draws);
+            SelectBits<TicTacToeState::kBoardSize>(empty, draws, picked);
+
+            for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+                placed[lane] = own[lane] | picked[lane];
+                won[lane] = 0;
+            }
+            for (auto win_mask : win_masks) {
+                for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+                    won[lane] |= static_cast<std::uint32_t>((placed[lane] & win_mask) == win_mask);
+                }
+            }
+
+            for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+                std::uint32_t full = static_cast<std::uint32_t>((placed[lane] | other[lane]) == kFullBoard);
+                finished[lane] = active[lane] & (won[lane] | full);
+                result[lane] = won[lane] ? player[lane] : kNone;
+
+                own[lane] = other[lane];
+                other[lane] = placed[lane];
+                player[lane] ^= 1;
+            }
+
+            for (unsigned lane = 0; lane < kBatchLanes; ++lane) {
+                if (!finished[lane]) continue;
+                outcomes[index[lane]] = result[lane];
+                load(lane);
+            }
+        }
+#endif
+    }
+
+    for (std::uint32_t i = 0; i < count; ++i) {
+        results[origins[i]] = outcomes[i];
+    }
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        if (results[i] == static_cast<std::uint32_t>(Player::kLeftPlayer)) values[i] = { 1.0, 0.0 };
+        else if (results[i] == static_cast<std::uint32_t>(Player::kRightPlayer)) values[i] = { 0.0, 1.0 };
+        else values[i] = { 0.5, 0.5 };
+    }
+}
+
+} // namespace boardgame
@@ -2,6 +2,8 @@
 #define MORRIS_GAMES_TIC_TAC_TOE_HPP
 
 #include "simulation.hpp"
+#include "batch.hpp"
+#include "../utility/random.hpp"
 
 namespace boardgame {
 
@@ -33,12 +35,22 @@ struct TicTacToeState {
         std::cout << "Player: " << PlayerToXO(player) << '\n';
     }
 
+    bool operator==(TicTacToeState const & other) const {
+        return player == other.player && board == other.board;
+    }
+
     Player player;
     std::array<Player, kBoardSize> board;
 };
 
 class TicTacToe {
 public:
+    // moves are numbered by MoveIndex from 0 to kMoveIndexCount - 1
+    static const unsigned kMoveIndexCount = TicTacToeState::kBoardSize;
+
+    // most moves a state can have, every cell of the empty board
+    static const unsigned kMaxBranchingFactor = TicTacToeState::kBoardSize;
+
     // returns whether the game is still on going and if not then who the winner is
     // winners include kLeftPlayer, kRightPlayer, and kNone
     static std::tuple<bool, Player> Winner(TicTacToeState const &state);
@@ -47,17 +59,110 @@ public:
     // depth is optional, often winning sooner (smaller depth) has better value
     static std::tuple<bool, std::array<double, 2>> StateValue(TicTacToeState const &state, unsigned depth = 0);
 
+    // value of a game that was not played to the end, there is no cheap heuristic so it is even
+    static std::array<double, 2> Evaluate(TicTacToeState const &state);
+
     // finds all next possible moves
     static std::vector<TicTacToeMove> ListMoves(TicTacToeState const &state);
 
+    // key that is different for every position, one bit per cell and player and the player to move
+    static std::uint64_t Hash(TicTacToeState const &state);
+
+    // the rotations and reflections of the board
+    static const unsigned kSymmetryCount = 8;
+
+    // the state with the board turned by the symmetry, symmetry 0 leaves it as it is
+    static TicTacToeState Transform(TicTacToeState const &state, unsigned symmetry);
+
+    static TicTacToeMove TransformMove(TicTacToeMove const &move, unsigned symmetry) {
+        return TicTacToeMove(kSymmetries[symmetry][move.destination]);
+    }
+
+    // the symmetry that turns the board back
+    static unsigned InverseSymmetry(unsigned symmetry) {
+        return kInverseSymmetries[symmetry];
+    }
+
+    // the symmetric state with the lowest hash and the symmetry that turns state into it
+    static std::tuple<TicTacToeState, unsigned> Canonical(TicTacToeState const &state);
+
+    // Hash of the canonical form, the same for all symmetric states
+    static std::uint64_t CanonicalHash(TicTacToeState const &state);
+
+    // inputs of a network, a plane of the cells of the player to move and one of the opponent
+    static const unsigned kFeatureCount = 2 * TicTacToeState::kBoardSize;
+    static void EncodeFeatures(TicTacToeState const &state, float *features);
+
+    // draws a uniform random empty cell without listing all the moves
+    template<class RandomEngineType>
+    static TicTacToeMove RandomMove(TicTacToeState const &state, RandomEngineType &random_engine) {
+        unsigned empty_count = 0;
+        for (auto player : state.board) {
+            empty_count += player == Player::kNone;
+        }
+
+        unsigned k = utility::Bounded(random_engine, empty_count);
+        for (unsigned i = 0; i < TicTacToeState::kBoardSize; ++i) {
+            if (state.board[i] == Player::kNone && k-- == 0) return TicTacToeMove(i);
+        }
+        return TicTacToeMove(-1);
+    }
+
+    // win if possible, otherwise block the opponent's win, otherwise play randomly
+    template<class RandomEngineType>
+    static TicTacToeMove HeavyMove(TicTacToeState const &state, RandomEngineType &random_engine) {
+        std::array<int, TicTacToeState::kBoardSize> cells;
+        for (auto player : { state.player, Opponent(state.player) }) {
+            unsigned count = CompletingCells(state, player, cells);
+            if (count > 0) return TicTacToeMove(cells[utility::Bounded(random_engine, count)]);
+        }
+        return RandomMove(state, random_engine);
+    }
+
+    // weight of a move for the search to try it first, winning moves before blocking moves before the rest
+    static double MovePrior(TicTacToeState const &state, TicTacToeMove const &move);
+
+    // moves the player to move has left if the board fills up, which the time manager spreads the clock over
+    static unsigned MovesToGo(TicTacToeState const &state);
+
+    // empty cells that would complete three in a row for player, returns how many were found
+    static unsigned CompletingCells(TicTacToeState const &state, Player player, std::array<int, TicTacToeState::kBoardSize> &cells);
+
     // get the next state using uniform random
-    static TicTacToeState SimulationPolicy(TicTacToeState const &state, std::mt19937_64 &random_engine);
+    template<class RandomEngineType>
+    static TicTacToeState SimulationPolicy(TicTacToeState const &state, RandomEngineType &random_engine) {
+        return ApplyMove(state, RandomMove(state, random_engine));
+    }
+
+    static unsigned MoveIndex(TicTacToeMove const &move) {
+        return static_cast<unsigned>(move.destination);
+    }
+
+    // small number that stands for the move in a game record
+    static std::uint16_t EncodeMove(TicTacToeMove const &move) {
+        return static_cast<std::uint16_t>(move.destination);
+    }
+    static TicTacToeMove DecodeMove(std::uint16_t code) {
+        return TicTacToeMove(static_cast<int>(code));
+    }
 
     // apply a move to a state
     static TicTacToeState ApplyMove(TicTacToeState const &state, TicTacToeMove const &move);
 
+    // play every state to the end with uniform random moves, kBatchLanes playouts at a time
+    // values receives the final state value of each playout
+    static void BatchSimulate(std::vector<TicTacToeState> const &states, std::uint64_t seed, std::vector<std::array<double, 2>> &values);
+
 private:
+    // the Hash of the board turned by the symmetry
+    static std::uint64_t SymmetricHash(TicTacToeState const &state, unsigned symmetry);
+
     static const std::array<std::array<int, 3>, 8> kWinCombos;
+
+    // kSymmetries[s][i] is the cell that cell i goes to, the quarter turns clockwise
+    // and then the same after reflecting left to right
+    static const std::array<std::array<int, TicTacToeState::kBoardSize>, kSymmetryCount> kSymmetries;
+    static const std::array<unsigned, kSymmetryCount> kInverseSymmetries;
 };
 
 } // namespace boardgame
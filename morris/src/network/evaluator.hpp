@@ -0,0 +1,192 @@
+#ifndef MORRIS_NETWORK_EVALUATOR_HPP_
+#define MORRIS_NETWORK_EVALUATOR_HPP_
+
+#include "../games/simulation.hpp"
+#include "network.hpp"
+
+namespace network {
+
+// runs the network for many search threads and games at once
+// every Evaluate blocks its thread until the batch is full, every attached search thread waits
+// or the first state of the batch waited max_wait, then one forward pass on the evaluator's own
+// thread answers all of them
+template<class GameType, class StateType>
+class BatchedEvaluator {
+public:
+    // whether the network reads the features and writes the move indices of the game
+    static bool Fits(Network const & network) {
+        return network.IsLoaded() && network.InputCount() == GameType::kFeatureCount && network.PolicyCount() == GameType::kMoveIndexCount;
+    }
+
+    // the network has to fit the game
+    BatchedEvaluator(Network network, unsigned max_batch = 32, std::chrono::microseconds max_wait = std::chrono::microseconds(500))
+    : network_(std::move(network)), max_batch_(std::max(1u, max_batch)), max_wait_(max_wait) {
+        thread_ = std::thread([this]() { Run(); });
+    }
+
+    ~BatchedEvaluator() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        request_condition_.notify_one();
+        thread_.join();
+    }
+
+    BatchedEvaluator(BatchedEvaluator const &) = delete;
+    BatchedEvaluator & operator=(BatchedEvaluator const &) = delete;
+
+    // policy gets a logit per move index and value the value in [-1, 1] for the player to move
+    void Evaluate(StateType const & state, std::vector<float> & policy, float & value) {
+        std::array<float, GameType::kFeatureCount> features;
+        GameType::EncodeFeatures(state, features.data());
+        policy.resize(GameType::kMoveIndexCount);
+
+        Request request { features.data(), policy.data(), &value, false };
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (pending_.empty()) first_arrival_ = std::chrono::steady_clock::now();
+        pending_.push_back(&request);
+        if (pending_.size() == 1 || Ready()) request_condition_.notify_one();
+        done_condition_.wait(lock, [&request]() { return request.done; });
+    }
+
+    // a search thread attaches while it searches, for example through MakeEvaluatorAttach
+    // with none of its attached threads left to send a state the batch runs right away
+    void Attach() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_ += 1;
+    }
+
+    void Detach() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_ -= 1;
+        if (Ready()) request_condition_.notify_one();
+    }
+
+    // forward passes so far and the states they evaluated
+    unsigned long long Batches() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return batches_;
+    }
+
+    unsigned long long Evaluations() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return evaluations_;
+    }
+
+private:
+    struct Request {
+        float const * features;
+        float * policy;
+        float * value;
+        bool done;
+    };
+
+    // whether the pending states make a batch without waiting, the lock is held
+    bool Ready() const {
+        return !pending_.empty() && (pending_.size() >= max_batch_ || (clients_ > 0 && pending_.size() >= clients_));
+    }
+
+    void Run() {
+        std::vector<Request *> batch;
+        std::vector<float> input, policy, values;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            request_condition_.wait(lock, [this]() { return stop_ || !pending_.empty(); });
+            if (pending_.empty()) return;
+
+            request_condition_.wait_until(lock, first_arrival_ + max_wait_, [this]() {
+                return stop_ || Ready();
+            });
+
+            std::size_t count = std::min<std::size_t>(pending_.size(), max_batch_);
+            batch.assign(pending_.begin(), pending_.begin() + count);
+            pending_.erase(pending_.begin(), pending_.begin() + count);
+            if (!pending_.empty()) first_arrival_ = std::chrono::steady_clock::now();
+            lock.unlock();
+
+            // the requesting threads wait, so their features and outputs can be used without the lock
+            input.resize(count * GameType::kFeatureCount);
+            policy.resize(count * GameType::kMoveIndexCount);
+            values.resize(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                std::copy(batch[i]->features, batch[i]->features + GameType::kFeatureCount, input.begin() + i * GameType::kFeatureCount);
+            }
+            network_.Forward(input.data(), static_cast<unsigned>(count), policy.data(), values.data());
+            for (std::size_t i = 0; i < count; ++i) {
+                auto row = policy.begin() + i * GameType::kMoveIndexCount;
+                std::copy(row, row + GameType::kMoveIndexCount, batch[i]->policy);
+                *batch[i]->value = values[i];
+            }
+
+            lock.lock();
+            for (auto * request : batch) {
+                request->done = true;
+            }
+            batches_ += 1;
+            evaluations_ += count;
+            done_condition_.notify_all();
+        }
+    }
+
+    Network network_;
+    unsigned max_batch_;
+    std::chrono::microseconds max_wait_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable request_condition_;
+    std::condition_variable done_condition_;
+    std::vector<Request *> pending_;
+    std::chrono::steady_clock::time_point first_arrival_;
+    std::size_t clients_ = 0;
+    bool stop_ = false;
+    unsigned long long batches_ = 0;
+    unsigned long long evaluations_ = 0;
+
+    std::thread thread_;
+};
+
+// the leaf evaluator of MonteCarloTreeSearch::SetEvaluator backed by a shared batched evaluator
+// the priors are the softmax of the logits of the legal moves and the value is spread so that
+// the player to move gets (1 + value) / 2 and everybody else the rest, like the games' StateValue
+template<class GameType, class StateType, unsigned PlayerCount = 2>
+auto MakeLeafEvaluator(std::shared_ptr<BatchedEvaluator<GameType, StateType>> evaluator) {
+    return [evaluator](StateType const & state, std::vector<unsigned> const & move_indices, std::vector<double> & priors) {
+        std::vector<float> policy;
+        float value = 0.0f;
+        evaluator->Evaluate(state, policy, value);
+
+        priors.resize(move_indices.size());
+        double largest = -std::numeric_limits<double>::infinity();
+        for (unsigned move_index : move_indices) {
+            largest = std::max(largest, static_cast<double>(policy[move_index]));
+        }
+        double sum = 0.0;
+        for (std::size_t i = 0; i < move_indices.size(); ++i) {
+            priors[i] = std::exp(policy[move_indices[i]] - largest);
+            sum += priors[i];
+        }
+        for (auto & prior : priors) {
+            prior /= sum;
+        }
+
+        std::array<double, PlayerCount> values;
+        values.fill((1.0 - value) / 2.0);
+        values[static_cast<unsigned>(state.player)] = (1.0 + value) / 2.0;
+        return values;
+    };
+}
+
+// the attach of MonteCarloTreeSearch::SetEvaluator for a shared batched evaluator
+template<class GameType, class StateType>
+auto MakeEvaluatorAttach(std::shared_ptr<BatchedEvaluator<GameType, StateType>> evaluator) {
+    return [evaluator](bool attach) {
+        if (attach) evaluator->Attach();
+        else evaluator->Detach();
+    };
+}
+
+} // namespace network
+
+#endif /* MORRIS_NETWORK_EVALUATOR_HPP_ */
@@ -0,0 +1,128 @@
+#ifndef MORRIS_NETWORK_KERNELS_HPP_
+#define MORRIS_NETWORK_KERNELS_HPP_
+
+// the vector kernels need avx2 and fma, which MORRIS_NATIVE_ARCH turns on for machines that have them
+// msvc has no macro for fma but every cpu with avx2 also has it
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define MORRIS_NETWORK_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace network {
+
+// samples whose dot products share every load of a weight row
+static const unsigned kSampleBlock = 4;
+
+#ifdef MORRIS_NETWORK_AVX2
+inline float HorizontalSum(__m256 x) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+inline std::int32_t HorizontalSum(__m256i x) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+// output[b][o] = bias[o] + sum over i of weights[o][i] * input[b][i]
+// the weights are row major with one row per output, the inputs and outputs one row per sample
+inline void Dense(float const * input, unsigned batch, unsigned inputs,
+                  float const * weights, float const * bias, unsigned outputs, float * output) {
+    for (unsigned first = 0; first < batch; first += kSampleBlock) {
+        unsigned count = std::min(kSampleBlock, batch - first);
+        float const * samples = input + static_cast<std::size_t>(first) * inputs;
+
+        for (unsigned o = 0; o < outputs; ++o) {
+            float const * row = weights + static_cast<std::size_t>(o) * inputs;
+            std::array<float, kSampleBlock> sums = {};
+            unsigned i = 0;
+#ifdef MORRIS_NETWORK_AVX2
+            __m256 vector_sums[kSampleBlock];
+            for (auto & vector_sum : vector_sums) vector_sum = _mm256_setzero_ps();
+            for (; i + 8 <= inputs; i += 8) {
+                __m256 w = _mm256_loadu_ps(row + i);
+                for (unsigned b = 0; b < count; ++b) {
+                    vector_sums[b] = _mm256_fmadd_ps(w, _mm256_loadu_ps(samples + b * inputs + i), vector_sums[b]);
+                }
+            }
+            for (unsigned b = 0; b < count; ++b) sums[b] = HorizontalSum(vector_sums[b]);
+#endif
+            for (; i < inputs; ++i) {
+                for (unsigned b = 0; b < count; ++b) {
+                    sums[b] += row[i] * samples[b * inputs + i];
+                }
+            }
+            for (unsigned b = 0; b < count; ++b) {
+                output[static_cast<std::size_t>(first + b) * outputs + o] = sums[b] + bias[o];
+            }
+        }
+    }
+}
+
+// the int8 version of Dense, every weight row and every input row has its own scale
+// so that its largest magnitude becomes 127, the products are summed exactly in 32 bits
+inline std::int32_t DotInt8(std::int8_t const * a, std::int8_t const * b, unsigned size) {
+    std::int32_t sum = 0;
+    unsigned i = 0;
+#ifdef MORRIS_NETWORK_AVX2
+    __m256i vector_sum = _mm256_setzero_si256();
+    for (; i + 16 <= size; i += 16) {
+        __m256i a16 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(a + i)));
+        __m256i b16 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(b + i)));
+        vector_sum = _mm256_add_epi32(vector_sum, _mm256_madd_epi16(a16, b16));
+    }
+    sum = HorizontalSum(vector_sum);
+#endif
+    for (; i < size; ++i) {
+        sum += static_cast<std::int32_t>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+// scale that maps the largest magnitude of the values to 127
+inline float QuantizationScale(float const * values, unsigned size) {
+    float largest = 0.0f;
+    for (unsigned i = 0; i < size; ++i) {
+        largest = std::max(largest, std::abs(values[i]));
+    }
+    return largest > 0.0f ? largest / 127.0f : 1.0f;
+}
+
+inline void Quantize(float const * values, unsigned size, float scale, std::int8_t * quantized) {
+    for (unsigned i = 0; i < size; ++i) {
+        quantized[i] = static_cast<std::int8_t>(std::lround(std::max(-127.0f, std::min(127.0f, values[i] / scale))));
+    }
+}
+
+// quantized_input is a buffer of batch * inputs values the inputs are quantized into
+inline void DenseInt8(float const * input, unsigned batch, unsigned inputs,
+                      std::int8_t const * weights, float const * weight_scales, float const * bias, unsigned outputs,
+                      std::vector<std::int8_t> & quantized_input, float * output) {
+    quantized_input.resize(static_cast<std::size_t>(batch) * inputs);
+    for (unsigned b = 0; b < batch; ++b) {
+        float const * sample = input + static_cast<std::size_t>(b) * inputs;
+        std::int8_t * quantized = quantized_input.data() + static_cast<std::size_t>(b) * inputs;
+        float input_scale = QuantizationScale(sample, inputs);
+        Quantize(sample, inputs, input_scale, quantized);
+
+        for (unsigned o = 0; o < outputs; ++o) {
+            std::int32_t sum = DotInt8(weights + static_cast<std::size_t>(o) * inputs, quantized, inputs);
+            output[static_cast<std::size_t>(b) * outputs + o] = sum * input_scale * weight_scales[o] + bias[o];
+        }
+    }
+}
+
+inline void Relu(float * values, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        values[i] = std::max(values[i], 0.0f);
+    }
+}
+
+} // namespace network
+
+#endif /* MORRIS_NETWORK_KERNELS_HPP_ */
@@ -0,0 +1,205 @@
+#ifndef MORRIS_NETWORK_NETWORK_HPP_
+#define MORRIS_NETWORK_NETWORK_HPP_
+
+#include "../utility/random.hpp"
+#include "kernels.hpp"
+
+namespace network {
+
+// a fully connected layer, the weights have one row of inputs per output
+struct Layer {
+    unsigned inputs = 0;
+    unsigned outputs = 0;
+    std::vector<float> weights;
+    std::vector<float> bias;
+
+    // the int8 weights and the scale of every row once the network is quantized
+    std::vector<std::int8_t> quantized_weights;
+    std::vector<float> weight_scales;
+};
+
+// a small policy and value network on the cpu
+// fully connected layers with relu, then a policy head with a logit per move index
+// and a value head with the tanh value for the player to move
+//
+// weights file
+//   "MNET", u32 version, u32 layer count, then per layer u32 inputs, u32 outputs,
+//   the f32 weights row by row and the f32 biases
+//   the last two layers are the policy and the value head, numbers are in the byte order of the machine
+class Network {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+
+    Network() = default;
+
+    // uniform glorot initialization, for trying out the plumbing without a trained network
+    static Network Random(unsigned input_count, std::vector<unsigned> const & hidden_sizes, unsigned policy_count, std::uint64_t seed) {
+        auto random_engine = utility::Xoshiro256PlusPlus(seed);
+        auto make_layer = [&random_engine](unsigned inputs, unsigned outputs) {
+            Layer layer;
+            layer.inputs = inputs;
+            layer.outputs = outputs;
+            layer.weights.resize(static_cast<std::size_t>(inputs) * outputs);
+            layer.bias.assign(outputs, 0.0f);
+            double limit = std::sqrt(6.0 / (inputs + outputs));
+            for (auto & weight : layer.weights) {
+                weight = static_cast<float>((2.0 * utility::UniformReal(random_engine) - 1.0) * limit);
+            }
+            return layer;
+        };
+
+        Network network;
+        unsigned inputs = input_count;
+        for (unsigned outputs : hidden_sizes) {
+            network.layers_.push_back(make_layer(inputs, outputs));
+            inputs = outputs;
+        }
+        network.layers_.push_back(make_layer(inputs, policy_count));
+        network.layers_.push_back(make_layer(inputs, 1));
+        return network;
+    }
+
+    // returns false when the file is missing or the layers do not fit together
+    bool Load(std::string const & path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        std::array<char, 4> magic;
+        std::uint32_t version = 0, layer_count = 0;
+        file.read(magic.data(), magic.size());
+        if (!file || magic != kMagic || !Read(file, version) || version != kVersion || !Read(file, layer_count) || layer_count < 2) {
+            return false;
+        }
+
+        std::vector<Layer> layers(layer_count);
+        for (auto & layer : layers) {
+            if (!Read(file, layer.inputs) || !Read(file, layer.outputs) || layer.inputs == 0 || layer.outputs == 0) return false;
+            layer.weights.resize(static_cast<std::size_t>(layer.inputs) * layer.outputs);
+            layer.bias.resize(layer.outputs);
+            if (!Read(file, layer.weights) || !Read(file, layer.bias)) return false;
+        }
+
+        // the trunk is a chain and both heads read its last layer
+        unsigned trunk_outputs = layers[0].inputs;
+        for (unsigned i = 0; i + 2 < layer_count; ++i) {
+            if (layers[i].inputs != trunk_outputs) return false;
+            trunk_outputs = layers[i].outputs;
+        }
+        if (layers[layer_count - 2].inputs != trunk_outputs || layers[layer_count - 1].inputs != trunk_outputs ||
+            layers[layer_count - 1].outputs != 1) {
+            return false;
+        }
+
+        layers_ = std::move(layers);
+        quantized_ = false;
+        return true;
+    }
+
+    bool Save(std::string const & path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(kMagic.data(), kMagic.size());
+        Write(file, kVersion);
+        Write(file, static_cast<std::uint32_t>(layers_.size()));
+        for (auto const & layer : layers_) {
+            Write(file, layer.inputs);
+            Write(file, layer.outputs);
+            Write(file, layer.weights);
+            Write(file, layer.bias);
+        }
+        return static_cast<bool>(file);
+    }
+
+    // from now on the layers run with int8 weights and inputs, about four times less memory
+    // to stream through and twice the products per instruction, at a small loss of precision
+    void Quantize() {
+        for (auto & layer : layers_) {
+            layer.quantized_weights.resize(layer.weights.size());
+            layer.weight_scales.resize(layer.outputs);
+            for (unsigned o = 0; o < layer.outputs; ++o) {
+                float const * row = layer.weights.data() + static_cast<std::size_t>(o) * layer.inputs;
+                layer.weight_scales[o] = QuantizationScale(row, layer.inputs);
+                network::Quantize(row, layer.inputs, layer.weight_scales[o],
+                    layer.quantized_weights.data() + static_cast<std::size_t>(o) * layer.inputs);
+            }
+        }
+        quantized_ = true;
+    }
+
+    bool IsQuantized() const {
+        return quantized_;
+    }
+
+    bool IsLoaded() const {
+        return layers_.size() >= 2;
+    }
+
+    unsigned InputCount() const {
+        return layers_.front().inputs;
+    }
+
+    unsigned PolicyCount() const {
+        return layers_[layers_.size() - 2].outputs;
+    }
+
+    // policy gets batch rows of PolicyCount logits and values batch values in [-1, 1]
+    // the buffers are reused between calls, so only one thread may run a network at a time
+    void Forward(float const * input, unsigned batch, float * policy, float * values) {
+        float const * activations = input;
+        for (std::size_t i = 0; i + 2 < layers_.size(); ++i) {
+            auto & output = i % 2 == 0 ? buffers_[0] : buffers_[1];
+            output.resize(static_cast<std::size_t>(batch) * layers_[i].outputs);
+            Run(layers_[i], activations, batch, output.data());
+            Relu(output.data(), output.size());
+            activations = output.data();
+        }
+
+        Run(layers_[layers_.size() - 2], activations, batch, policy);
+        Run(layers_.back(), activations, batch, values);
+        for (unsigned b = 0; b < batch; ++b) {
+            values[b] = std::tanh(values[b]);
+        }
+    }
+
+private:
+    static constexpr std::array<char, 4> kMagic = { 'M', 'N', 'E', 'T' };
+
+    void Run(Layer const & layer, float const * input, unsigned batch, float * output) {
+        if (quantized_) {
+            DenseInt8(input, batch, layer.inputs, layer.quantized_weights.data(), layer.weight_scales.data(),
+                      layer.bias.data(), layer.outputs, quantized_input_, output);
+        } else {
+            Dense(input, batch, layer.inputs, layer.weights.data(), layer.bias.data(), layer.outputs, output);
+        }
+    }
+
+    template<class T>
+    static bool Read(std::istream & in, T & value) {
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+    }
+
+    template<class T>
+    static bool Read(std::istream & in, std::vector<T> & values) {
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(T)));
+    }
+
+    template<class T>
+    static void Write(std::ostream & out, T const & value) {
+        out.write(reinterpret_cast<char const *>(&value), sizeof(T));
+    }
+
+    template<class T>
+    static void Write(std::ostream & out, std::vector<T> const & values) {
+        out.write(reinterpret_cast<char const *>(values.data()), values.size() * sizeof(T));
+    }
+
+    std::vector<Layer> layers_;
+    bool quantized_ = false;
+
+    // activations of the hidden layers alternate between the two buffers
+    std::array<std::vector<float>, 2> buffers_;
+    std::vector<std::int8_t> quantized_input_;
+};
+
+} // namespace network
+
+#endif /* MORRIS_NETWORK_NETWORK_HPP_ */
@@ -0,0 +1,100 @@
+#ifndef MORRIS_TOURNAMENT_ELO_HPP_
+#define MORRIS_TOURNAMENT_ELO_HPP_
+
+namespace tournament {
+
+// wins, draws and losses of the first engine
+struct Score {
+    unsigned wins = 0;
+    unsigned draws = 0;
+    unsigned losses = 0;
+
+    unsigned Games() const {
+        return wins + draws + losses;
+    }
+
+    // mean points per game, a draw is half a point
+    double Mean() const {
+        return Games() == 0 ? 0.5 : (wins + 0.5 * draws) / Games();
+    }
+
+    // variance of the points of a single game
+    double Variance() const {
+        if (Games() == 0) return 0.0;
+        double mean = Mean();
+        return (wins * (1.0 - mean) * (1.0 - mean) + draws * (0.5 - mean) * (0.5 - mean) + losses * mean * mean) / Games();
+    }
+};
+
+// elo difference that gives the expected score
+inline double ScoreToElo(double score) {
+    score = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+inline double EloToScore(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+struct EloEstimate {
+    double elo;
+    double lower;
+    double upper;
+};
+
+// elo difference of the first engine with a confidence interval, 1.96 standard errors is 95%
+inline EloEstimate Elo(Score const & score, double z = 1.96) {
+    double mean = score.Mean();
+    double error = score.Games() == 0 ? 0.5 : std::sqrt(score.Variance() / score.Games());
+    return { ScoreToElo(mean), ScoreToElo(mean - z * error), ScoreToElo(mean + z * error) };
+}
+
+// sequential probability ratio test of H0: elo = elo0 against H1: elo = elo1
+// using the normal approximation of the log likelihood ratio
+class Sprt {
+public:
+    enum class Decision {
+        kContinue,
+        kAcceptH0,
+        kAcceptH1
+    };
+
+    Sprt(double elo0 = 0.0, double elo1 = 10.0, double alpha = 0.05, double beta = 0.05)
+    : elo0_(elo0), elo1_(elo1),
+      lower_bound_(std::log(beta / (1.0 - alpha))), upper_bound_(std::log((1.0 - beta) / alpha)) {
+    }
+
+    double LogLikelihoodRatio(Score const & score) const {
+        double variance = score.Variance();
+        if (score.Games() == 0 || variance <= 0.0) return 0.0;
+
+        double score0 = EloToScore(elo0_);
+        double score1 = EloToScore(elo1_);
+        return score.Games() * (score1 - score0) * (2.0 * score.Mean() - score0 - score1) / (2.0 * variance);
+    }
+
+    Decision Decide(Score const & score) const {
+        double llr = LogLikelihoodRatio(score);
+        if (llr <= lower_bound_) return Decision::kAcceptH0;
+        if (llr >= upper_bound_) return Decision::kAcceptH1;
+        return Decision::kContinue;
+    }
+
+    double LowerBound() const {
+        return lower_bound_;
+    }
+
+    double UpperBound() const {
+        return upper_bound_;
+    }
+
+private:
+    double elo0_;
+    double elo1_;
+    double lower_bound_;
+    double upper_bound_;
+};
+
+} // namespace tournament
+
+#endif /* MORRIS_TOURNAMENT_ELO_HPP_ */
@@ -0,0 +1,159 @@
+#ifndef MORRIS_TOURNAMENT_MATCH_HPP_
+#define MORRIS_TOURNAMENT_MATCH_HPP_
+
+#include "../games/simulation.hpp"
+#include "../utility/random.hpp"
+#include "elo.hpp"
+
+namespace tournament {
+
+struct MatchSettings {
+    unsigned games = 100;
+
+    // games played at the same time, 0 uses one per hardware thread
+    unsigned concurrency = 0;
+
+    // games that are still going after this many plies are scored as a draw
+    unsigned max_plies = 1000;
+
+    // milliseconds on the clock of each engine for a game and added after each of its moves
+    // 0 plays without a clock, see Simulation::SetClock
+    long long clock_time = 0;
+    long long clock_increment = 0;
+
+    // stop as soon as the sprt comes to a decision
+    bool use_sprt = false;
+    Sprt sprt;
+
+    std::uint64_t seed = 0;
+};
+
+struct MatchReport {
+    Score score;
+
+    // time of every move of the first and the second engine in milliseconds
+    std::array<std::vector<double>, 2> move_times;
+
+    // games the first and the second engine lost because their clock ran out
+    std::array<unsigned, 2> time_losses = {};
+
+    double seconds = 0.0;
+    Sprt::Decision decision = Sprt::Decision::kContinue;
+};
+
+// value below which the given fraction of the samples fall
+inline double Percentile(std::vector<double> samples, double fraction) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    auto index = static_cast<std::size_t>(std::ceil(fraction * samples.size()));
+    return samples[std::min(std::max<std::size_t>(index, 1), samples.size()) - 1];
+}
+
+template<class T, class = void>
+struct HasSetSeed : std::false_type {};
+
+template<class T>
+struct HasSetSeed<T, std::void_t<decltype(std::declval<T &>().SetSeed(std::uint64_t()))>> : std::true_type {};
+
+// plays the first engine against the second one on several games at once
+// the first engine is always the left player and the games alternate who starts
+template<class GameType, class StateType, class MoveType, class FirstAlgorithmType, class SecondAlgorithmType>
+class Match {
+public:
+    Match(FirstAlgorithmType first, SecondAlgorithmType second, MatchSettings settings)
+    : first_(first), second_(second), settings_(settings) {
+        if (settings_.concurrency == 0) {
+            unsigned concurrent_threads = std::thread::hardware_concurrency();
+            settings_.concurrency = concurrent_threads == 0 ? 4 : concurrent_threads;
+        }
+    }
+
+    // progress is called after every finished game while holding the report lock
+    // and so is record with every state of that game
+    MatchReport Run(std::function<void(MatchReport const &)> const & progress = nullptr,
+                    std::function<void(std::vector<StateType> const &)> const & record = nullptr) {
+        MatchReport report;
+        std::mutex report_mutex;
+        std::atomic<unsigned> next_game(0);
+        std::atomic<bool> stop(false);
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto worker = [&](unsigned worker_index) {
+            MORRIS_TRACE_THREAD_NAME("match worker " + std::to_string(worker_index));
+
+            // every worker gets its own copies of the engines with their own seeds
+            std::uint64_t seed = settings_.seed + worker_index;
+            FirstAlgorithmType first = first_;
+            SecondAlgorithmType second = second_;
+            if constexpr (HasSetSeed<FirstAlgorithmType>::value) first.SetSeed(utility::SplitMix64(seed));
+            if constexpr (HasSetSeed<SecondAlgorithmType>::value) second.SetSeed(utility::SplitMix64(seed));
+
+            boardgame::Simulation<GameType, StateType, MoveType, FirstAlgorithmType, SecondAlgorithmType>
+                simulation(StateType(boardgame::Player::kLeftPlayer), first, second);
+            simulation.SetClock(settings_.clock_time, settings_.clock_increment);
+
+            std::array<std::vector<double>, 2> move_times;
+            while (!stop.load()) {
+                unsigned game = next_game++;
+                if (game >= settings_.games) break;
+
+                // pairs of games swap the starting player so neither engine gets the advantage
+                auto starting_player = game % 2 == 0 ? boardgame::Player::kLeftPlayer : boardgame::Player::kRightPlayer;
+                simulation.Initialize(StateType(starting_player));
+
+                std::tuple<bool, boardgame::Player> winner = boardgame::kOnGoingGame;
+                for (unsigned ply = 0; std::get<0>(winner) && ply < settings_.max_plies; ++ply) {
+                    auto mover = static_cast<unsigned>(simulation.State().player);
+                    auto move_start = std::chrono::steady_clock::now();
+                    winner = simulation.Move();
+                    auto move_end = std::chrono::steady_clock::now();
+                    move_times[mover].push_back(std::chrono::duration<double, std::milli>(move_end - move_start).count());
+                }
+                auto result = std::get<0>(winner) ? boardgame::Player::kNone : std::get<1>(winner);
+
+                std::lock_guard<std::mutex> lock(report_mutex);
+                if (result == boardgame::Player::kLeftPlayer) report.score.wins += 1;
+                else if (result == boardgame::Player::kRightPlayer) report.score.losses += 1;
+                else report.score.draws += 1;
+                if (result != boardgame::Player::kNone && simulation.RemainingTime(boardgame::Opponent(result)) < 0) {
+                    report.time_losses[static_cast<unsigned>(boardgame::Opponent(result))] += 1;
+                }
+
+                if (settings_.use_sprt) {
+                    report.decision = settings_.sprt.Decide(report.score);
+                    if (report.decision != Sprt::Decision::kContinue) stop.store(true);
+                }
+                if (progress) progress(report);
+                if (record) record(simulation.History());
+            }
+
+            std::lock_guard<std::mutex> lock(report_mutex);
+            for (unsigned i = 0; i < 2; ++i) {
+                report.move_times[i].insert(report.move_times[i].end(), move_times[i].begin(), move_times[i].end());
+            }
+        };
+
+        std::vector<std::thread> workers;
+        unsigned worker_count = std::min(settings_.concurrency, std::max(1u, settings_.games));
+        for (unsigned i = 0; i < worker_count; ++i) {
+            workers.emplace_back(worker, i);
+        }
+        for (auto & thread : workers) {
+            thread.join();
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        report.seconds = std::chrono::duration<double>(end - start).count();
+        return report;
+    }
+
+private:
+    FirstAlgorithmType first_;
+    SecondAlgorithmType second_;
+    MatchSettings settings_;
+};
+
+} // namespace tournament
+
+#endif /* MORRIS_TOURNAMENT_MATCH_HPP_ */
@@ -0,0 +1,95 @@
+#ifndef MORRIS_UTILITY_BOUNDED_QUEUE_HPP_
+#define MORRIS_UTILITY_BOUNDED_QUEUE_HPP_
+
+namespace utility {
+
+// fixed size queue for many producers and many consumers without locks
+// every cell has a sequence number that tells whether it is free for the push of a position
+// or holds the value for the pop of that position, so producers and consumers only race
+// on the compare exchange of the tail or the head
+template<class T>
+class BoundedQueue {
+public:
+    // the capacity is rounded up to a power of two
+    explicit BoundedQueue(std::size_t capacity) : cells_(RoundUp(capacity)), mask_(cells_.size() - 1) {
+        for (std::size_t i = 0; i < cells_.size(); ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(BoundedQueue const &) = delete;
+    BoundedQueue & operator=(BoundedQueue const &) = delete;
+
+    std::size_t Capacity() const {
+        return cells_.size();
+    }
+
+    // the value is only moved from when it was pushed
+    bool TryPush(T & value) {
+        Cell * cell;
+        std::size_t position = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[position & mask_];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+            if (difference == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T & value) {
+        Cell * cell;
+        std::size_t position = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[position & mask_];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+            if (difference == 0) {
+                if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = head_.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->value);
+        cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // waits while the queue is full
+    void Push(T value) {
+        while (!TryPush(value)) std::this_thread::yield();
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static std::size_t RoundUp(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) size *= 2;
+        return size;
+    }
+
+    std::vector<Cell> cells_;
+    std::size_t mask_;
+
+    // on their own cache lines so producers and consumers do not slow each other down
+    alignas(64) std::atomic<std::size_t> tail_ { 0 };
+    alignas(64) std::atomic<std::size_t> head_ { 0 };
+};
+
+} // namespace utility
+
+#endif /* MORRIS_UTILITY_BOUNDED_QUEUE_HPP_ */
@@ -0,0 +1,93 @@
+#ifndef MORRIS_UTILITY_HISTOGRAM_HPP_
+#define MORRIS_UTILITY_HISTOGRAM_HPP_
+
+namespace utility {
+
+// counts values in power of two buckets: 0, 1, 2-3, 4-7, 8-15, ...
+class Histogram {
+public:
+    static const unsigned kBucketCount = 33;
+
+    void Add(std::uint64_t value) {
+        buckets_[Bucket(value)] += 1;
+        count_ += 1;
+        sum_ += value;
+        max_ = std::max(max_, value);
+    }
+
+    void Merge(Histogram const & other) {
+        for (unsigned i = 0; i < kBucketCount; ++i) {
+            buckets_[i] += other.buckets_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    void Clear() {
+        *this = Histogram();
+    }
+
+    std::uint64_t Count() const {
+        return count_;
+    }
+
+    std::uint64_t Max() const {
+        return max_;
+    }
+
+    double Mean() const {
+        return count_ == 0 ? 0.0 : static_cast<double>(sum_) / count_;
+    }
+
+    // upper bound of the bucket the given fraction of the values falls into
+    std::uint64_t Percentile(double fraction) const {
+        auto target = static_cast<std::uint64_t>(std::ceil(fraction * count_));
+        std::uint64_t seen = 0;
+        for (unsigned i = 0; i < kBucketCount; ++i) {
+            seen += buckets_[i];
+            if (seen >= target && buckets_[i] > 0) return std::min(UpperBound(i), max_);
+        }
+        return max_;
+    }
+
+    std::array<std::uint64_t, kBucketCount> const & Buckets() const {
+        return buckets_;
+    }
+
+    // smallest and largest value counted by a bucket
+    static std::uint64_t LowerBound(unsigned bucket) {
+        return bucket == 0 ? 0 : std::uint64_t(1) << (bucket - 1);
+    }
+
+    static std::uint64_t UpperBound(unsigned bucket) {
+        return bucket == 0 ? 0 : (std::uint64_t(1) << bucket) - 1;
+    }
+
+    void Print() const {
+        std::cout << "count: " << count_ << ", mean: " << Mean() << ", max: " << max_ << '\n';
+        for (unsigned i = 0; i < kBucketCount; ++i) {
+            if (buckets_[i] == 0) continue;
+            std::cout << LowerBound(i) << "-" << UpperBound(i) << ": " << buckets_[i] << '\n';
+        }
+    }
+
+private:
+    static unsigned Bucket(std::uint64_t value) {
+        unsigned bucket = 0;
+        while (value != 0 && bucket < kBucketCount - 1) {
+            value >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    std::array<std::uint64_t, kBucketCount> buckets_ = {};
+    std::uint64_t count_ = 0;
+    std::uint64_t sum_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+} // namespace utility
+
+#endif /* MORRIS_UTILITY_HISTOGRAM_HPP_ */
@@ -0,0 +1,85 @@
+#ifndef MORRIS_UTILITY_MAPPED_FILE_HPP_
+#define MORRIS_UTILITY_MAPPED_FILE_HPP_
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace utility {
+
+// a whole file mapped read only into memory, the pages are only read when touched
+class MappedFile {
+public:
+    explicit MappedFile(std::string const & path) {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) return;
+        size_ = static_cast<std::size_t>(size.QuadPart);
+
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr) return;
+        data_ = static_cast<std::uint8_t const *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+#else
+        file_ = open(path.c_str(), O_RDONLY);
+        if (file_ < 0) return;
+
+        struct stat status;
+        if (fstat(file_, &status) != 0 || status.st_size == 0) return;
+        size_ = static_cast<std::size_t>(status.st_size);
+
+        void * data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, file_, 0);
+        if (data != MAP_FAILED) data_ = static_cast<std::uint8_t const *>(data);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data_ != nullptr) UnmapViewOfFile(data_);
+        if (mapping_ != nullptr) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+        if (data_ != nullptr) munmap(const_cast<std::uint8_t *>(data_), size_);
+        if (file_ >= 0) close(file_);
+#endif
+    }
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile & operator=(MappedFile const &) = delete;
+
+    bool IsOpen() const {
+        return data_ != nullptr;
+    }
+
+    std::uint8_t const * Data() const {
+        return data_;
+    }
+
+    std::size_t Size() const {
+        return size_;
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int file_ = -1;
+#endif
+    std::uint8_t const * data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+} // namespace utility
+
+#endif /* MORRIS_UTILITY_MAPPED_FILE_HPP_ */
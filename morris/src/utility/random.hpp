@@ -0,0 +1,189 @@
+#ifndef MORRIS_UTILITY_RANDOM_HPP_
+#define MORRIS_UTILITY_RANDOM_HPP_
+
+// random engines for the rollouts, all of them satisfy UniformRandomBitGenerator
+// so they can be used anywhere std::mt19937_64 was used before
+
+namespace utility {
+
+// splitmix64, used to expand a single seed into full engine states
+inline std::uint64_t SplitMix64(std::uint64_t & state) {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+inline std::uint64_t RotateLeft(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// xoshiro256++ by Blackman and Vigna, 2^256 - 1 period and four words of state
+class Xoshiro256PlusPlus {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256PlusPlus(std::uint64_t seed = 0) {
+        for (auto & word : state_) {
+            word = SplitMix64(seed);
+        }
+    }
+
+    // the stream of the same seed is split into non overlapping parts of 2^128 draws
+    Xoshiro256PlusPlus(std::uint64_t seed, unsigned stream) : Xoshiro256PlusPlus(seed) {
+        for (unsigned i = 0; i < stream; ++i) {
+            Jump();
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        result_type result = RotateLeft(state_[0] + state_[3], 23) + state_[0];
+        result_type t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = RotateLeft(state_[3], 45);
+        return result;
+    }
+
+    // equivalent to 2^128 calls of the engine
+    void Jump() {
+        static const std::uint64_t kJump[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+
+        std::array<std::uint64_t, 4> jumped = { 0, 0, 0, 0 };
+        for (auto jump : kJump) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if (jump & (std::uint64_t(1) << bit)) {
+                    for (unsigned i = 0; i < 4; ++i) {
+                        jumped[i] ^= state_[i];
+                    }
+                }
+                (*this)();
+            }
+        }
+        state_ = jumped;
+    }
+
+private:
+    std::array<std::uint64_t, 4> state_;
+};
+
+// pcg32 (XSH RR) by O'Neill, a single word of state and selectable streams
+class Pcg32 {
+public:
+    using result_type = std::uint32_t;
+
+    explicit Pcg32(std::uint64_t seed = 0, unsigned stream = 0)
+    : state_(0), increment_((static_cast<std::uint64_t>(stream) << 1) | 1) {
+        (*this)();
+        state_ += SplitMix64(seed);
+        (*this)();
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        std::uint64_t old_state = state_;
+        state_ = old_state * 6364136223846793005ULL + increment_;
+        auto xor_shifted = static_cast<std::uint32_t>(((old_state >> 18) ^ old_state) >> 27);
+        auto rotation = static_cast<std::uint32_t>(old_state >> 59);
+        return (xor_shifted >> rotation) | (xor_shifted << ((32 - rotation) & 31));
+    }
+
+private:
+    std::uint64_t state_;
+    std::uint64_t increment_;
+};
+
+// counter based engine, every draw is a hash of (key, counter)
+// any position of the stream can be reached directly which keeps runs reproducible
+// no matter how the work is split between threads
+class CounterRandom {
+public:
+    using result_type = std::uint64_t;
+
+    explicit CounterRandom(std::uint64_t seed = 0, unsigned stream = 0) : counter_(0) {
+        std::uint64_t mixer = seed ^ (static_cast<std::uint64_t>(stream) * 0xd1342543de82ef95ULL);
+        key_ = SplitMix64(mixer);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        std::uint64_t position = key_ + counter_++ * 0x9e3779b97f4a7c15ULL;
+        return SplitMix64(position);
+    }
+
+    void Discard(std::uint64_t count) {
+        counter_ += count;
+    }
+
+    void SetCounter(std::uint64_t counter) {
+        counter_ = counter;
+    }
+
+private:
+    std::uint64_t key_;
+    std::uint64_t counter_;
+};
+
+// create the engine for one of several threads sharing a seed
+// engines without streams get a different seed per stream instead
+template<class RandomEngineType>
+RandomEngineType MakeRandomEngine(std::uint64_t seed, unsigned stream) {
+    if constexpr (std::is_constructible<RandomEngineType, std::uint64_t, unsigned>::value) {
+        return RandomEngineType(seed, stream);
+    } else {
+        std::uint64_t mixer = seed + stream;
+        return RandomEngineType(static_cast<typename RandomEngineType::result_type>(SplitMix64(mixer)));
+    }
+}
+
+// 32 random bits, the upper ones of 64 bit engines
+template<class RandomEngineType>
+std::uint32_t Next32(RandomEngineType & random_engine) {
+    if constexpr (RandomEngineType::max() > std::numeric_limits<std::uint32_t>::max()) {
+        return static_cast<std::uint32_t>(random_engine() >> 32);
+    } else {
+        return static_cast<std::uint32_t>(random_engine());
+    }
+}
+
+// uniform number in [0, bound) with Lemire's multiply and shift
+// the division only happens in the rare case the draw has to be checked for bias
+template<class RandomEngineType>
+std::uint32_t Bounded(RandomEngineType & random_engine, std::uint32_t bound) {
+    std::uint64_t product = static_cast<std::uint64_t>(Next32(random_engine)) * bound;
+    auto low = static_cast<std::uint32_t>(product);
+    if (low < bound) {
+        std::uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            product = static_cast<std::uint64_t>(Next32(random_engine)) * bound;
+            low = static_cast<std::uint32_t>(product);
+        }
+    }
+    return static_cast<std::uint32_t>(product >> 32);
+}
+
+// uniform number in [0, 1)
+template<class RandomEngineType>
+double UniformReal(RandomEngineType & random_engine) {
+    return Next32(random_engine) * (1.0 / 4294967296.0);
+}
+
+// a random seed from the operating system
+inline std::uint64_t RandomSeed() {
+    std::random_device device;
+    return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+}
+
+} // namespace utility
+
+#endif /* MORRIS_UTILITY_RANDOM_HPP_ */
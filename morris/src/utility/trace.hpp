@@ -0,0 +1,145 @@
+#ifndef MORRIS_UTILITY_TRACE_HPP_
+#define MORRIS_UTILITY_TRACE_HPP_
+
+// a timeline of what every thread did, written as a chrome trace json that chrome://tracing
+// and ui.perfetto.dev open, to see for example how evenly the search threads share the work
+//
+// the trace points only exist in a build with the cmake option MORRIS_TRACING, otherwise
+// the macros are empty and cost nothing
+//   MORRIS_TRACE_SCOPE("name")              a span from here to the end of the scope
+//   MORRIS_TRACE_SPAN("name", begin, end)   a span between two time points of any clock
+//   MORRIS_TRACE_THREAD_NAME(name)          the name of the calling thread's row, a std::string
+//   MORRIS_TRACE_WRITE(path)                writes every span so far, while nothing is traced
+// names of spans are string literals, only the pointer is kept
+
+#ifdef MORRIS_TRACING
+
+#include <iomanip>
+
+namespace utility {
+namespace trace {
+
+struct Event {
+    char const * name;
+
+    // nanoseconds since the tracer started
+    long long begin;
+    long long duration;
+};
+
+// every thread appends to its own buffer without locking, the tracer keeps them after the thread ends
+struct ThreadBuffer {
+    unsigned id;
+    std::string name;
+    std::vector<Event> events;
+};
+
+class Tracer {
+public:
+    static Tracer & Instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    long long Now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    ThreadBuffer & Buffer() {
+        thread_local ThreadBuffer * buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.push_back(std::make_unique<ThreadBuffer>());
+            buffer = buffers_.back().get();
+            buffer->id = static_cast<unsigned>(buffers_.size());
+            buffer->name = "thread " + std::to_string(buffer->id);
+        }
+        return *buffer;
+    }
+
+    void Add(char const * name, long long begin, long long end) {
+        begin = std::max(0ll, begin);
+        Buffer().events.push_back({ name, begin, std::max(0ll, end - begin) });
+    }
+
+    bool Write(std::string const & path) {
+        std::ofstream file(path, std::ios::trunc);
+        std::lock_guard<std::mutex> lock(mutex_);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        auto separate = [&file, &first]() {
+            if (!first) file << ",\n";
+            first = false;
+        };
+        for (auto const & buffer : buffers_) {
+            separate();
+            file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+                 << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+            for (auto const & event : buffer->events) {
+                separate();
+                file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                     << ",\"ts\":" << event.begin / 1000 << '.' << std::setw(3) << std::setfill('0') << event.begin % 1000
+                     << ",\"dur\":" << event.duration / 1000 << '.' << std::setw(3) << std::setfill('0') << event.duration % 1000 << '}';
+            }
+        }
+        file << "]}\n";
+        return static_cast<bool>(file);
+    }
+
+private:
+    Tracer() : start_(std::chrono::steady_clock::now()) {
+    }
+
+    std::chrono::steady_clock::time_point start_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+class Scope {
+public:
+    explicit Scope(char const * name) : name_(name), begin_(Tracer::Instance().Now()) {
+    }
+
+    ~Scope() {
+        Tracer::Instance().Add(name_, begin_, Tracer::Instance().Now());
+    }
+
+    Scope(Scope const &) = delete;
+    Scope & operator=(Scope const &) = delete;
+
+private:
+    char const * name_;
+    long long begin_;
+};
+
+// the time points of another clock are placed by how long before now they were
+template<class TimePoint>
+void Span(char const * name, TimePoint begin, TimePoint end) {
+    auto & tracer = Tracer::Instance();
+    long long now = tracer.Now();
+    auto clock_now = TimePoint::clock::now();
+    tracer.Add(name,
+        now - std::chrono::duration_cast<std::chrono::nanoseconds>(clock_now - begin).count(),
+        now - std::chrono::duration_cast<std::chrono::nanoseconds>(clock_now - end).count());
+}
+
+} // namespace trace
+} // namespace utility
+
+#define MORRIS_TRACE_CONCAT_(a, b) a##b
+#define MORRIS_TRACE_CONCAT(a, b) MORRIS_TRACE_CONCAT_(a, b)
+#define MORRIS_TRACE_SCOPE(name) ::utility::trace::Scope MORRIS_TRACE_CONCAT(morris_trace_scope_, __LINE__)(name)
+#define MORRIS_TRACE_SPAN(name, begin, end) ::utility::trace::Span(name, begin, end)
+#define MORRIS_TRACE_THREAD_NAME(thread_name) (::utility::trace::Tracer::Instance().Buffer().name = (thread_name))
+#define MORRIS_TRACE_WRITE(path) ::utility::trace::Tracer::Instance().Write(path)
+
+#else
+
+#define MORRIS_TRACE_SCOPE(name) ((void)0)
+#define MORRIS_TRACE_SPAN(name, begin, end) ((void)0)
+#define MORRIS_TRACE_THREAD_NAME(thread_name) ((void)0)
+#define MORRIS_TRACE_WRITE(path) false
+
+#endif
+
+#endif /* MORRIS_UTILITY_TRACE_HPP_ */
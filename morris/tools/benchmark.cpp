@@ -0,0 +1,294 @@
+#include "pch.hpp"
+#include "games/simulation.hpp"
+#include "games/tic_tac_toe.hpp"
+#include "games/nine_men_morris.hpp"
+#include "games/connect_4.hpp"
+#include "algorithms/min_max.hpp"
+#include "algorithms/mcts.hpp"
+#include "utility/random.hpp"
+#include "utility/trace.hpp"
+
+// times the game kernels and the searches on a fixed corpus of positions and prints json
+// the seeds are fixed, so the checksums only change when the behavior does
+//
+// benchmark --game all --min-time 200 --positions 32 --filter playout --output result.json
+//   --game       tictactoe, connect4, morris or all, or one of the other boards connect5, morris6 or morris12
+//   --min-time   milliseconds every benchmark runs at least
+//   --positions  positions per game phase
+//   --filter     only run benchmarks whose name contains this
+//   --seed       seed of the corpus and the playouts
+//   --trace      writes a chrome trace of the searches, in a build with MORRIS_TRACING
+
+using namespace boardgame;
+using namespace algorithm;
+
+using Options = std::map<std::string, std::string>;
+
+static std::string Option(Options const & options, std::string const & name, std::string const & fallback) {
+    auto found = options.find(name);
+    return found != options.end() ? found->second : fallback;
+}
+
+struct Settings {
+    std::string filter;
+    std::chrono::milliseconds min_time;
+    unsigned positions;
+    std::uint64_t seed;
+};
+
+// operations done by one pass of a benchmark and a value that depends on all of them
+struct Pass {
+    unsigned long long operations = 0;
+    unsigned long long checksum = 0;
+};
+
+struct Result {
+    std::string game;
+    std::string phase;
+    std::string name;
+    unsigned long long operations;
+    double seconds;
+    unsigned long long checksum;
+};
+
+// plies from the start after which the positions of a phase are taken
+struct Phase {
+    std::string name;
+    unsigned min_plies;
+    unsigned max_plies;
+};
+
+// repeats the pass until the minimum time is reached, the checksum is the one of the first pass
+template<class PassType>
+void Measure(Settings const & settings, std::string const & game, std::string const & phase, std::string const & name,
+             PassType pass, std::vector<Result> & results) {
+    if (name.find(settings.filter) == std::string::npos) return;
+
+    Result result { game, phase, name, 0, 0.0, 0 };
+    auto start = std::chrono::steady_clock::now();
+    auto end = start;
+    for (unsigned i = 0; i == 0 || end - start < settings.min_time; ++i) {
+        Pass done = pass();
+        if (i == 0) result.checksum = done.checksum;
+        result.operations += done.operations;
+        end = std::chrono::steady_clock::now();
+    }
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    results.push_back(result);
+
+    std::cerr << game << ' ' << phase << ' ' << name << ": " << result.operations / result.seconds << "/s\n";
+}
+
+// ongoing positions reached by uniformly random play
+template<class GameType, class StateType>
+std::vector<StateType> Corpus(Phase const & phase, unsigned count, std::uint64_t seed) {
+    auto random_engine = utility::Xoshiro256PlusPlus(seed);
+    std::vector<StateType> corpus;
+    while (corpus.size() < count) {
+        unsigned plies = phase.min_plies + utility::Bounded(random_engine, phase.max_plies - phase.min_plies + 1);
+        StateType state(corpus.size() % 2 == 0 ? Player::kLeftPlayer : Player::kRightPlayer);
+        unsigned ply = 0;
+        for (; ply < plies && GameType::Winner(state) == kOnGoingGame; ++ply) {
+            state = GameType::ApplyMove(state, GameType::RandomMove(state, random_engine));
+        }
+        // games that ended early are thrown away and played again
+        if (ply == plies && GameType::Winner(state) == kOnGoingGame) {
+            corpus.push_back(state);
+        }
+    }
+    return corpus;
+}
+
+template<class GameType, class StateType, class MoveType>
+void Benchmark(Settings const & settings, std::string const & game, std::vector<Phase> const & phases,
+               unsigned min_max_depth, unsigned mcts_iterations, std::vector<Result> & results) {
+    for (unsigned phase_index = 0; phase_index < phases.size(); ++phase_index) {
+        auto const & phase = phases[phase_index];
+        auto corpus = Corpus<GameType, StateType>(phase, settings.positions, settings.seed + phase_index);
+
+        std::vector<std::vector<MoveType>> corpus_moves;
+        for (auto const & state : corpus) {
+            corpus_moves.push_back(GameType::ListMoves(state));
+        }
+
+        Measure(settings, game, phase.name, "list_moves", [&]() {
+            Pass pass;
+            for (auto const & state : corpus) {
+                pass.checksum += GameType::ListMoves(state).size();
+                pass.operations += 1;
+            }
+            return pass;
+        }, results);
+
+        Measure(settings, game, phase.name, "apply_move", [&]() {
+            Pass pass;
+            for (unsigned i = 0; i < corpus.size(); ++i) {
+                for (auto const & move : corpus_moves[i]) {
+                    auto next_state = GameType::ApplyMove(corpus[i], move);
+                    pass.checksum += static_cast<unsigned>(next_state.player);
+                    pass.operations += 1;
+                }
+            }
+            return pass;
+        }, results);
+
+        Measure(settings, game, phase.name, "winner", [&]() {
+            Pass pass;
+            for (unsigned i = 0; i < corpus.size(); ++i) {
+                for (auto const & move : corpus_moves[i]) {
+                    auto next_state = GameType::ApplyMove(corpus[i], move);
+                    pass.checksum += static_cast<unsigned>(std::get<1>(GameType::Winner(next_state)));
+                    pass.operations += 1;
+                }
+            }
+            return pass;
+        }, results);
+
+        Measure(settings, game, phase.name, "state_value", [&]() {
+            Pass pass;
+            for (unsigned i = 0; i < corpus.size(); ++i) {
+                for (auto const & move : corpus_moves[i]) {
+                    auto next_state = GameType::ApplyMove(corpus[i], move);
+                    auto value = GameType::StateValue(next_state);
+                    pass.checksum += static_cast<unsigned long long>(std::get<1>(value)[0] * 1000.0);
+                    pass.operations += 1;
+                }
+            }
+            return pass;
+        }, results);
+
+        Measure(settings, game, phase.name, "random_playout", [&]() {
+            Pass pass;
+            auto random_engine = utility::Xoshiro256PlusPlus(settings.seed);
+            for (auto state : corpus) {
+                std::tuple<bool, Player> winner;
+                while ((winner = GameType::Winner(state)) == kOnGoingGame) {
+                    state = GameType::ApplyMove(state, GameType::RandomMove(state, random_engine));
+                }
+                pass.checksum += static_cast<unsigned>(std::get<1>(winner));
+                pass.operations += 1;
+            }
+            return pass;
+        }, results);
+
+        Measure(settings, game, phase.name, "batch_playout", [&]() {
+            Pass pass;
+            std::vector<std::array<double, 2>> values;
+            GameType::BatchSimulate(corpus, settings.seed, values);
+            for (auto const & value : values) {
+                pass.checksum += static_cast<unsigned long long>(value[0] * 2.0);
+            }
+            pass.operations = corpus.size();
+            return pass;
+        }, results);
+
+        // the searches are slow, so they only use a few of the positions
+        unsigned search_positions = std::min<unsigned>(4, static_cast<unsigned>(corpus.size()));
+
+        Measure(settings, game, phase.name, "mcts_iteration", [&]() {
+            Pass pass;
+            for (unsigned i = 0; i < search_positions; ++i) {
+                MonteCarloTreeSearch<GameType, StateType, 2> search(mcts_iterations, std::numeric_limits<long long>::max(), 1.0, 1);
+                search.SetSeed(settings.seed);
+                auto next_state = search.Compute(corpus[i]);
+                pass.checksum += static_cast<unsigned>(std::get<1>(GameType::Winner(next_state)));
+                pass.operations += mcts_iterations;
+            }
+            return pass;
+        }, results);
+
+        Measure(settings, game, phase.name, "min_max_node", [&]() {
+            Pass pass;
+            for (unsigned i = 0; i < search_positions; ++i) {
+                MinMax<GameType, StateType, MoveType> search(min_max_depth);
+                search.Compute(corpus[i]);
+                pass.checksum += search.Nodes();
+                pass.operations += search.Nodes();
+            }
+            return pass;
+        }, results);
+    }
+}
+
+static void PrintJson(std::ostream & out, Settings const & settings, std::vector<Result> const & results) {
+    out << "{\n"
+        << "  \"seed\": " << settings.seed << ",\n"
+        << "  \"positions\": " << settings.positions << ",\n"
+        << "  \"min_time_ms\": " << settings.min_time.count() << ",\n"
+        << "  \"benchmarks\": [\n";
+    for (unsigned i = 0; i < results.size(); ++i) {
+        auto const & result = results[i];
+        out << "    {"
+            << "\"game\": \"" << result.game << "\", "
+            << "\"phase\": \"" << result.phase << "\", "
+            << "\"name\": \"" << result.name << "\", "
+            << "\"operations\": " << result.operations << ", "
+            << "\"seconds\": " << result.seconds << ", "
+            << "\"per_second\": " << result.operations / result.seconds << ", "
+            << "\"checksum\": " << result.checksum << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n"
+        << "}\n";
+}
+
+int main(int argc, const char * argv[]) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key.compare(0, 2, "--") != 0) {
+            std::cerr << "expected an option instead of " << key << '\n';
+            return 1;
+        }
+        options[key.substr(2)] = argv[i + 1];
+    }
+
+    Settings settings;
+    settings.filter = Option(options, "filter", "");
+    settings.min_time = std::chrono::milliseconds(std::stoll(Option(options, "min-time", "200")));
+    settings.positions = std::max(1u, static_cast<unsigned>(std::stoul(Option(options, "positions", "32"))));
+    settings.seed = std::stoull(Option(options, "seed", "1"));
+
+    std::string game = Option(options, "game", "all");
+    std::vector<Result> results;
+    if (game == "all" || game == "tictactoe") {
+        Benchmark<TicTacToe, TicTacToeState, TicTacToeMove>(settings, "tictactoe",
+            { { "opening", 0, 2 }, { "middlegame", 3, 4 }, { "endgame", 5, 6 } }, 9, 1000, results);
+    }
+    if (game == "all" || game == "connect4") {
+        Benchmark<Connect4, Connect4State, Connect4Move>(settings, "connect4",
+            { { "opening", 0, 6 }, { "middlegame", 12, 20 }, { "endgame", 26, 34 } }, 6, 1000, results);
+    }
+    if (game == "all" || game == "morris") {
+        Benchmark<NineMenMorris, NineMenMorrisState, NineMenMorrisMove>(settings, "morris",
+            { { "opening", 0, 10 }, { "middlegame", 20, 40 }, { "endgame", 60, 100 } }, 3, 1000, results);
+    }
+    if (game == "connect5") {
+        Benchmark<Connect5, Connect5State, ConnectNMove>(settings, "connect5",
+            { { "opening", 0, 8 }, { "middlegame", 16, 26 }, { "endgame", 34, 44 } }, 6, 1000, results);
+    }
+    if (game == "morris6") {
+        Benchmark<SixMenMorris, SixMenMorrisState, MorrisMove>(settings, "morris6",
+            { { "opening", 0, 6 }, { "middlegame", 14, 30 }, { "endgame", 50, 80 } }, 3, 1000, results);
+    }
+    if (game == "morris12") {
+        Benchmark<TwelveMenMorris, TwelveMenMorrisState, MorrisMove>(settings, "morris12",
+            { { "opening", 0, 12 }, { "middlegame", 26, 46 }, { "endgame", 66, 106 } }, 3, 1000, results);
+    }
+
+    std::string output = Option(options, "output", "");
+    if (output.empty()) {
+        PrintJson(std::cout, settings, results);
+    }
+    else {
+        std::ofstream file(output);
+        PrintJson(file, settings, results);
+    }
+
+    std::string trace = Option(options, "trace", "");
+    if (!trace.empty() && !MORRIS_TRACE_WRITE(trace)) {
+        std::cerr << "cannot write the trace " << trace << ", the build needs MORRIS_TRACING\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include "pch.hpp"
+#include "games/simulation.hpp"
+#include "games/tic_tac_toe.hpp"
+#include "games/nine_men_morris.hpp"
+#include "games/connect_4.hpp"
+#include "algorithms/random_play.hpp"
+#include "algorithms/min_max.hpp"
+#include "algorithms/mcts.hpp"
+#include "network/evaluator.hpp"
+#include "tournament/match.hpp"
+#include "games/game_record.hpp"
+#include "utility/trace.hpp"
+
+// plays two engines against each other and reports the elo difference
+//
+// match_runner --game connect4 --games 200 --first mcts --second mcts-heavy --iterations 2000
+//
+// games are tictactoe, connect4, connect5, morris6, morris and morris12
+// engines are random, minmax, proof-number, mcts, mcts-heavy and mcts-network, every engine option can
+// be given for both engines (--iterations 1000) or for one of them (--first-iterations 1000)
+//   --depth N          minmax depth, or the deepest it goes on a clock
+//   --pn-nodes N       nodes of the proof number search per move
+//   --pn-precheck N    mcts first plays a win df-pn proves in N nodes and leaves out moves it proves to lose
+//   --iterations N     mcts iterations per move, unlimited on a clock
+//   --time MS          mcts time per move
+//   --rave K           rave equivalence, 0 is off
+//   --solver 0|1       mcts solver
+//   --epsilon E        random move fraction of mcts-heavy
+//   --network PATH     weights of the policy and value network of mcts-network
+//   --quantize 0|1     run the network with int8 weights
+//   --batch N          leaves of all games evaluated in one forward pass, by default every search thread of
+//                      the games at once, a batch also runs once all threads searching with the engine wait
+//   --max-wait US      microseconds the first leaf of a batch waits for the batch to fill
+//   --c-puct C         exploration of the PUCT selection
+//   --prior heuristic  select with PUCT on the game's MovePrior
+//   --fpu V            value of unvisited children instead of visiting them all first
+//   --memory MB        memory of the mcts trees of a move, the least visited subtrees are pruned, 0 is unbounded
+// match options
+//   --games N --concurrency N --max-plies N --seed N
+//   --clock MS --increment MS   game clock of each engine, mcts searches and minmax deepens as long as
+//                               the clock allows, an engine whose clock runs out loses
+//   --sprt 0|1 --elo0 E --elo1 E --alpha A --beta B
+//   --record PATH      writes every game to a game record file
+//   --trace PATH       writes a chrome trace of the moves and searches, in a build with MORRIS_TRACING
+
+using namespace boardgame;
+using namespace algorithm;
+
+using Options = std::map<std::string, std::string>;
+
+static std::string Option(Options const & options, std::string const & engine, std::string const & name, std::string const & fallback) {
+    auto found = options.find(engine + "-" + name);
+    if (found != options.end()) return found->second;
+    found = options.find(name);
+    return found != options.end() ? found->second : fallback;
+}
+
+static std::string Option(Options const & options, std::string const & name, std::string const & fallback) {
+    auto found = options.find(name);
+    return found != options.end() ? found->second : fallback;
+}
+
+template<class GameType, class StateType, class RolloutPolicyType>
+MonteCarloTreeSearch<GameType, StateType, 2, utility::Xoshiro256PlusPlus, RolloutPolicyType>
+MakeSearch(Options const & options, std::string const & engine, unsigned thread_count, RolloutPolicyType rollout_policy) {
+    std::string default_iterations = options.count("clock") ? std::to_string(std::numeric_limits<unsigned>::max()) : "1000";
+    unsigned iterations = std::stoul(Option(options, engine, "iterations", default_iterations));
+    long long time = std::stoll(Option(options, engine, "time", std::to_string(std::numeric_limits<long long>::max())));
+
+    MonteCarloTreeSearch<GameType, StateType, 2, utility::Xoshiro256PlusPlus, RolloutPolicyType>
+        search(iterations, time, 1.0, thread_count);
+    search.SetRolloutPolicy(rollout_policy);
+    search.SetRave(std::stoul(Option(options, engine, "rave", "0")));
+    search.SetSolver(Option(options, engine, "solver", "0") != "0");
+    if (Option(options, engine, "prior", "none") == "heuristic") {
+        search.SetPrior(HeuristicPrior<GameType>(), std::stod(Option(options, engine, "c-puct", "1.5")));
+    }
+    search.SetProofNumberPrecheck(std::stoull(Option(options, engine, "pn-precheck", "0")));
+    std::string first_play_urgency = Option(options, engine, "fpu", "");
+    if (!first_play_urgency.empty()) search.SetFirstPlayUrgency(std::stod(first_play_urgency));
+    search.SetMemoryLimit(static_cast<std::size_t>(std::stoull(Option(options, engine, "memory", "0"))) << 20);
+    return search;
+}
+
+// calls run with the engine named by the option, whose searches run thread_count threads each
+// in game_count games at once
+template<class GameType, class StateType, class RunType>
+int WithEngine(Options const & options, std::string const & engine, unsigned thread_count, unsigned game_count, RunType run) {
+    std::string name = Option(options, engine, "mcts");
+    if (name == "random") {
+        return run(RandomPlay<GameType, StateType>());
+    }
+    if (name == "minmax") {
+        using MoveType = typename decltype(GameType::ListMoves(std::declval<StateType const &>()))::value_type;
+        std::string default_depth = options.count("clock") ? std::to_string(std::numeric_limits<unsigned>::max()) : "4";
+        return run(MinMax<GameType, StateType, MoveType>(std::stoul(Option(options, engine, "depth", default_depth))));
+    }
+    if (name == "proof-number") {
+        return run(ProofNumberSearch<GameType, StateType>(std::stoull(Option(options, engine, "pn-nodes", "1000000"))));
+    }
+    if (name == "mcts") {
+        return run(MakeSearch<GameType, StateType>(options, engine, thread_count, UniformRollout<GameType>()));
+    }
+    if (name == "mcts-heavy") {
+        double epsilon = std::stod(Option(options, engine, "epsilon", "0.1"));
+        return run(MakeSearch<GameType, StateType>(options, engine, thread_count, HeavyRollout<GameType>(epsilon)));
+    }
+    if (name == "mcts-network") {
+        std::string path = Option(options, engine, "network", "");
+        network::Network weights;
+        if (!weights.Load(path) || !network::BatchedEvaluator<GameType, StateType>::Fits(weights)) {
+            std::cerr << "cannot load a network for this game from " << path << '\n';
+            return 1;
+        }
+        if (Option(options, engine, "quantize", "0") != "0") weights.Quantize();
+
+        // one evaluator batches the leaves of every game of the match, at most one per search thread
+        // is waiting, and while the other engine moves only the threads that attached count
+        std::string batch = std::to_string(thread_count * game_count);
+        auto evaluator = std::make_shared<network::BatchedEvaluator<GameType, StateType>>(
+            std::move(weights), std::stoul(Option(options, engine, "batch", batch)),
+            std::chrono::microseconds(std::stoll(Option(options, engine, "max-wait", "500"))));
+        auto search = MakeSearch<GameType, StateType>(options, engine, thread_count, UniformRollout<GameType>());
+        search.SetEvaluator(network::MakeLeafEvaluator<GameType, StateType>(evaluator), std::stod(Option(options, engine, "c-puct", "1.5")),
+                            network::MakeEvaluatorAttach<GameType, StateType>(evaluator));
+        return run(search);
+    }
+    std::cerr << "unknown engine " << name << '\n';
+    return 1;
+}
+
+static void PrintMoveTimes(std::string const & engine, std::vector<double> const & move_times) {
+    std::cout
+        << engine << " move time ms"
+        << " p50: " << tournament::Percentile(move_times, 0.50)
+        << " p90: " << tournament::Percentile(move_times, 0.90)
+        << " p99: " << tournament::Percentile(move_times, 0.99)
+        << " max: " << tournament::Percentile(move_times, 1.00)
+        << " moves: " << move_times.size() << '\n';
+}
+
+template<class GameType, class StateType, class MoveType>
+int RunMatch(Options const & options) {
+    tournament::MatchSettings settings;
+    settings.games = std::stoul(Option(options, "games", "100"));
+    settings.concurrency = std::stoul(Option(options, "concurrency", "0"));
+    settings.max_plies = std::stoul(Option(options, "max-plies", "1000"));
+    settings.clock_time = std::stoll(Option(options, "clock", "0"));
+    settings.clock_increment = std::stoll(Option(options, "increment", "0"));
+    settings.seed = std::stoull(Option(options, "seed", std::to_string(utility::RandomSeed())));
+    settings.use_sprt = Option(options, "sprt", "0") != "0";
+    settings.sprt = tournament::Sprt(
+        std::stod(Option(options, "elo0", "0")), std::stod(Option(options, "elo1", "10")),
+        std::stod(Option(options, "alpha", "0.05")), std::stod(Option(options, "beta", "0.05")));
+
+    // the games running at once share the cores, so every search gets its part of them
+    unsigned concurrent_threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned concurrency = settings.concurrency == 0 ? concurrent_threads : settings.concurrency;
+    unsigned thread_count = std::max(1u, concurrent_threads / concurrency);
+
+    unsigned game_count = std::min(concurrency, std::max(1u, settings.games));
+
+    return WithEngine<GameType, StateType>(options, "first", thread_count, game_count, [&](auto first) {
+        return WithEngine<GameType, StateType>(options, "second", thread_count, game_count, [&](auto second) {
+            tournament::Match<GameType, StateType, MoveType, decltype(first), decltype(second)> match(first, second, settings);
+
+            std::string record_path = Option(options, "record", "");
+            std::unique_ptr<GameRecordWriter<GameType, StateType, MoveType>> writer;
+            if (!record_path.empty()) {
+                writer = std::make_unique<GameRecordWriter<GameType, StateType, MoveType>>(record_path);
+                if (!writer->IsOpen()) {
+                    std::cerr << "cannot write the record " << record_path << '\n';
+                    return 1;
+                }
+            }
+
+            unsigned reported = 0;
+            auto report = match.Run([&](tournament::MatchReport const & report) {
+                unsigned games = report.score.Games();
+                if (games * 10 / settings.games > reported) {
+                    reported = games * 10 / settings.games;
+                    auto elo = tournament::Elo(report.score);
+                    std::cout << games << " games, elo " << elo.elo << '\n';
+                }
+            }, [&](std::vector<StateType> const & history) {
+                if (writer) writer->WriteGame(history);
+            });
+            if (writer) writer->Close();
+
+            auto elo = tournament::Elo(report.score);
+            std::cout
+                << "first: " << report.score.wins << ", "
+                << "second: " << report.score.losses << ", "
+                << "draw: " << report.score.draws << '\n'
+                << "elo: " << elo.elo << " [" << elo.lower << ", " << elo.upper << "]\n";
+            if (settings.use_sprt) {
+                std::cout
+                    << "sprt llr: " << settings.sprt.LogLikelihoodRatio(report.score)
+                    << " [" << settings.sprt.LowerBound() << ", " << settings.sprt.UpperBound() << "] "
+                    << (report.decision == tournament::Sprt::Decision::kAcceptH1 ? "H1 accepted" :
+                        report.decision == tournament::Sprt::Decision::kAcceptH0 ? "H0 accepted" : "undecided") << '\n';
+            }
+            PrintMoveTimes("first", report.move_times[0]);
+            PrintMoveTimes("second", report.move_times[1]);
+            if (settings.clock_time > 0) {
+                std::cout << "time losses first: " << report.time_losses[0] << ", second: " << report.time_losses[1] << '\n';
+            }
+            std::cout << "seconds: " << report.seconds << '\n';
+
+            std::string trace = Option(options, "trace", "");
+            if (!trace.empty() && !MORRIS_TRACE_WRITE(trace)) {
+                std::cerr << "cannot write the trace " << trace << ", the build needs MORRIS_TRACING\n";
+                return 1;
+            }
+            return 0;
+        });
+    });
+}
+
+int main(int argc, const char * argv[]) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key.compare(0, 2, "--") != 0) {
+            std::cerr << "expected an option instead of " << key << '\n';
+            return 1;
+        }
+        options[key.substr(2)] = argv[i + 1];
+    }
+
+    std::string game = Option(options, "game", "connect4");
+    if (game == "tictactoe") return RunMatch<TicTacToe, TicTacToeState, TicTacToeMove>(options);
+    if (game == "connect4") return RunMatch<Connect4, Connect4State, Connect4Move>(options);
+    if (game == "connect5") return RunMatch<Connect5, Connect5State, ConnectNMove>(options);
+    if (game == "morris6") return RunMatch<SixMenMorris, SixMenMorrisState, MorrisMove>(options);
+    if (game == "morris") return RunMatch<NineMenMorris, NineMenMorrisState, NineMenMorrisMove>(options);
+    if (game == "morris12") return RunMatch<TwelveMenMorris, TwelveMenMorrisState, MorrisMove>(options);
+
+    std::cerr << "unknown game " << game << '\n';
+    return 1;
+}
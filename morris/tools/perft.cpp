@@ -0,0 +1,290 @@
+#include "pch.hpp"
+#include "games/simulation.hpp"
+#include "games/tic_tac_toe.hpp"
+#include "games/nine_men_morris.hpp"
+#include "games/connect_4.hpp"
+#include "games/game_traits.hpp"
+#include "utility/random.hpp"
+
+// counts the positions reached after exactly depth moves, to check and time the move generators
+// positions where the game has ended count as leaves only at the full depth
+//
+// perft --game morris --depth 6 --threads 8 --hash 64 --position "........................ x 9 9"
+//   --game      tictactoe, connect4, connect5, morris6, morris or morris12
+//   --depth     every depth from 1 up to this one is counted and timed
+//   --threads   threads that split the moves of the root, 0 uses one per hardware thread
+//   --hash      megabytes of the transposition table, 0 turns it off
+//   --divide    1 prints the count below every root move at the last depth
+//   --symmetry  1 keys the table by the canonical form so symmetric positions share entries, 0 turns it off
+//   --outcomes  1 also counts the games that ended at the last depth by their result, on one thread
+//               and without the table, for example a draw on the board filled during placement:
+//               perft --game morris12 --depth 1 --outcomes 1 --position "xoooxooxxxoxoxx.xxxoooxo o 0 1"
+//   --position  the position to start from, the side to move is x or o
+//     tictactoe  9 cells of x, o or . row by row, then the side: "x...o.... x"
+//     connect4   7 rows of 6 cells from the top separated by /, then the side
+//     connect5   8 rows of 7 cells in the same way
+//     morris     24 cells, the side, then the pieces x and o still have to place
+//     morris6    16 cells and morris12 24 cells in the same way
+
+using namespace boardgame;
+
+using Options = std::map<std::string, std::string>;
+
+static std::string Option(Options const & options, std::string const & name, std::string const & fallback) {
+    auto found = options.find(name);
+    return found != options.end() ? found->second : fallback;
+}
+
+static bool ParsePlayer(char cell, Player & player) {
+    if (cell == 'x') player = Player::kLeftPlayer;
+    else if (cell == 'o') player = Player::kRightPlayer;
+    else if (cell == '.') player = Player::kNone;
+    else return false;
+    return true;
+}
+
+static bool ParseState(std::string const & position, TicTacToeState & state) {
+    std::istringstream in(position);
+    std::string board, side;
+    if (!(in >> board >> side) || board.size() != TicTacToeState::kBoardSize || side.size() != 1) return false;
+
+    for (unsigned i = 0; i < TicTacToeState::kBoardSize; ++i) {
+        if (!ParsePlayer(board[i], state.board[i])) return false;
+    }
+    return ParsePlayer(side[0], state.player) && state.player != Player::kNone;
+}
+
+template<unsigned Width, unsigned Height, unsigned ConnectCount>
+static bool ParseState(std::string const & position, ConnectNState<Width, Height, ConnectCount> & state) {
+    std::istringstream in(position);
+    std::string board, side;
+    if (!(in >> board >> side) || side.size() != 1) return false;
+    if (board.size() != Height * (Width + 1) - 1) return false;
+
+    for (unsigned y = 0; y < Height; ++y) {
+        for (unsigned x = 0; x < Width; ++x) {
+            if (!ParsePlayer(board[y * (Width + 1) + x], state.board[x][y])) return false;
+        }
+    }
+    return ParsePlayer(side[0], state.player) && state.player != Player::kNone;
+}
+
+template<class Board>
+static bool ParseState(std::string const & position, MorrisState<Board> & state) {
+    std::istringstream in(position);
+    std::string board, side;
+    std::array<unsigned, 2> to_place;
+    if (!(in >> board >> side >> to_place[0] >> to_place[1])) return false;
+    if (board.size() != Board::kBoardSize || side.size() != 1) return false;
+
+    std::array<unsigned, 2> on_board = { 0, 0 };
+    for (unsigned i = 0; i < Board::kBoardSize; ++i) {
+        if (!ParsePlayer(board[i], state.board[i])) return false;
+        if (state.board[i] != Player::kNone) ++on_board[static_cast<unsigned>(state.board[i])];
+    }
+    if (!ParsePlayer(side[0], state.player) || state.player == Player::kNone) return false;
+
+    for (auto player : { Player::kLeftPlayer, Player::kRightPlayer }) {
+        unsigned index = static_cast<unsigned>(player);
+        state.SetRemainingToPlay(player, to_place[index]);
+        state.SetRemaining(player, on_board[index] + to_place[index]);
+        state.SetStage(player,
+            to_place[index] > 0 ? MorrisPhase::kPlacement :
+            state.Remaining(player) <= 3 ? MorrisPhase::kFreeMovement :
+            MorrisPhase::kMovement);
+    }
+    state.SetHash(Morris<Board>::BoardHash(state));
+    return true;
+}
+
+// counts below a position shared by all threads, every entry is two words and the key word is
+// stored xor the count so a torn read never matches
+class PerftTable {
+public:
+    PerftTable(std::size_t megabytes, bool canonical) : canonical_(canonical) {
+        std::size_t entries = 1;
+        while (entries * 2 * sizeof(Entry) <= megabytes * 1024 * 1024) entries *= 2;
+        entries_ = std::vector<Entry>(entries);
+        mask_ = entries - 1;
+    }
+
+    // whether the positions are keyed by the hash of their canonical form
+    bool Canonical() const {
+        return canonical_;
+    }
+
+    bool Probe(std::uint64_t hash, unsigned depth, std::uint64_t & count) const {
+        std::uint64_t key = Key(hash, depth);
+        auto const & entry = entries_[key & mask_];
+        std::uint64_t stored_count = entry.count.load(std::memory_order_relaxed);
+        if ((entry.key.load(std::memory_order_relaxed) ^ stored_count) != key) return false;
+        count = stored_count;
+        return true;
+    }
+
+    void Store(std::uint64_t hash, unsigned depth, std::uint64_t count) {
+        std::uint64_t key = Key(hash, depth);
+        auto & entry = entries_[key & mask_];
+        entry.key.store(key ^ count, std::memory_order_relaxed);
+        entry.count.store(count, std::memory_order_relaxed);
+    }
+
+private:
+    struct Entry {
+        std::atomic<std::uint64_t> key { 0 };
+        std::atomic<std::uint64_t> count { 0 };
+    };
+
+    static std::uint64_t Key(std::uint64_t hash, unsigned depth) {
+        std::uint64_t key = hash ^ (depth * 0x9e3779b97f4a7c15ULL);
+        return utility::SplitMix64(key);
+    }
+
+    std::vector<Entry> entries_;
+    std::size_t mask_;
+    bool canonical_;
+};
+
+// symmetric positions have the same counts below them, so they can share an entry
+template<class GameType, class StateType>
+std::uint64_t TableHash(StateType const & state, bool canonical) {
+    if constexpr (game_traits::kHasSymmetries<GameType, StateType>) {
+        if (canonical) return GameType::CanonicalHash(state);
+    }
+    return GameType::Hash(state);
+}
+
+template<class GameType, class StateType>
+std::uint64_t Perft(StateType const & state, unsigned depth, PerftTable * table) {
+    if (depth == 0) return 1;
+    if (GameType::Winner(state) != kOnGoingGame) return 0;
+
+    auto moves = GameType::ListMoves(state);
+    if (depth == 1) return moves.size();
+
+    std::uint64_t hash = 0, count = 0;
+    if (table) {
+        hash = TableHash<GameType>(state, table->Canonical());
+        if (table->Probe(hash, depth, count)) return count;
+    }
+
+    for (auto const & move : moves) {
+        count += Perft<GameType, StateType>(GameType::ApplyMove(state, move), depth - 1, table);
+    }
+
+    if (table) table->Store(hash, depth, count);
+    return count;
+}
+
+// the games that ended exactly at the depth, counted by the winner, the last one are draws
+template<class GameType, class StateType>
+void Outcomes(StateType const & state, unsigned depth, std::array<std::uint64_t, 3> & outcomes) {
+    auto winner = GameType::Winner(state);
+    if (!std::get<0>(winner)) {
+        if (depth == 0) ++outcomes[static_cast<unsigned>(std::get<1>(winner))];
+        return;
+    }
+    if (depth == 0) return;
+
+    for (auto const & move : GameType::ListMoves(state)) {
+        Outcomes<GameType, StateType>(GameType::ApplyMove(state, move), depth - 1, outcomes);
+    }
+}
+
+// the threads take the root moves one at a time and count below them
+template<class GameType, class StateType>
+std::vector<std::uint64_t> SplitPerft(StateType const & state, unsigned depth, unsigned thread_count, PerftTable * table) {
+    auto moves = GameType::ListMoves(state);
+    std::vector<std::uint64_t> counts(moves.size(), 0);
+    if (GameType::Winner(state) != kOnGoingGame) return counts;
+
+    std::atomic<std::size_t> next_move(0);
+    auto worker = [&]() {
+        for (std::size_t i = next_move++; i < moves.size(); i = next_move++) {
+            counts[i] = Perft<GameType, StateType>(GameType::ApplyMove(state, moves[i]), depth - 1, table);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    return counts;
+}
+
+template<class GameType, class StateType>
+int RunPerft(Options const & options) {
+    StateType state(Player::kLeftPlayer);
+    std::string position = Option(options, "position", "");
+    if (!position.empty() && !ParseState(position, state)) {
+        std::cerr << "cannot read the position " << position << '\n';
+        return 1;
+    }
+
+    unsigned max_depth = std::stoul(Option(options, "depth", "4"));
+    unsigned thread_count = std::stoul(Option(options, "threads", "0"));
+    if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t hash_megabytes = std::stoul(Option(options, "hash", "0"));
+    bool divide = Option(options, "divide", "0") != "0";
+    bool canonical = Option(options, "symmetry", "1") != "0";
+    bool outcomes = Option(options, "outcomes", "0") != "0";
+
+    std::unique_ptr<PerftTable> table;
+    if (hash_megabytes > 0) table = std::make_unique<PerftTable>(hash_megabytes, canonical);
+
+    auto moves = GameType::ListMoves(state);
+    for (unsigned depth = 1; depth <= max_depth; ++depth) {
+        auto start = std::chrono::steady_clock::now();
+        auto counts = SplitPerft<GameType, StateType>(state, depth, thread_count, table.get());
+        auto end = std::chrono::steady_clock::now();
+
+        std::uint64_t count = 0;
+        for (auto root_count : counts) count += root_count;
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        std::cout
+            << "depth " << depth
+            << " nodes " << count
+            << " seconds " << seconds
+            << " nodes/s " << (seconds > 0.0 ? count / seconds : 0.0) << '\n';
+
+        if (outcomes && depth == max_depth) {
+            std::array<std::uint64_t, 3> counts_by_winner = {};
+            Outcomes<GameType, StateType>(state, depth, counts_by_winner);
+            std::cout << "  ended x " << counts_by_winner[0] << " o " << counts_by_winner[1] << " draw " << counts_by_winner[2] << '\n';
+        }
+
+        if (divide && depth == max_depth) {
+            for (std::size_t i = 0; i < moves.size(); ++i) {
+                std::cout << "  move " << i << " index " << GameType::MoveIndex(moves[i]) << ": " << counts[i] << '\n';
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, const char * argv[]) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key.compare(0, 2, "--") != 0) {
+            std::cerr << "expected an option instead of " << key << '\n';
+            return 1;
+        }
+        options[key.substr(2)] = argv[i + 1];
+    }
+
+    std::string game = Option(options, "game", "morris");
+    if (game == "tictactoe") return RunPerft<TicTacToe, TicTacToeState>(options);
+    if (game == "connect4") return RunPerft<Connect4, Connect4State>(options);
+    if (game == "connect5") return RunPerft<Connect5, Connect5State>(options);
+    if (game == "morris6") return RunPerft<SixMenMorris, SixMenMorrisState>(options);
+    if (game == "morris") return RunPerft<NineMenMorris, NineMenMorrisState>(options);
+    if (game == "morris12") return RunPerft<TwelveMenMorris, TwelveMenMorrisState>(options);
+
+    std::cerr << "unknown game " << game << '\n';
+    return 1;
+}
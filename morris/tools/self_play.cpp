@@ -0,0 +1,293 @@
+#include "pch.hpp"
+#include "games/simulation.hpp"
+#include "games/tic_tac_toe.hpp"
+#include "games/nine_men_morris.hpp"
+#include "games/connect_4.hpp"
+#include "games/game_record.hpp"
+#include "algorithms/mcts.hpp"
+#include "utility/bounded_queue.hpp"
+#include "utility/random.hpp"
+
+// plays mcts against itself on all cores and writes training data for a policy and value network
+// every position of a game becomes a sample of the state, the root visits of the search as a
+// distribution over the game's MoveIndex and the result of the game for the player to move
+//
+// self_play --game morris --games 1000 --iterations 800 --output morris.selfplay
+//   --game          tictactoe, connect4, connect5, morris6, morris or morris12
+//   --games         games to play
+//   --concurrency   games played at once, 0 gives every hardware thread a search thread
+//   --threads       threads of every search
+//   --iterations    mcts iterations per move
+//   --sample-plies  the first plies of a game pick a move in proportion to its visits for variety
+//   --max-plies     games still going after this many plies are draws
+//   --chunk         samples per chunk of the file
+//   --queue         finished games the queue to the writer holds
+//   --seed          seed of the searches and the sampled moves
+//   --output        the file to write
+//
+// file    "MSPF", u32 version, u32 size of a state, u32 move index count, then chunks until the end
+// chunk   "MSPC", u32 sample count, u64 bytes of the samples that follow
+// sample  the raw state, i8 result for the player to move (1, 0 or -1), u16 count of moves,
+//         then per move a u16 MoveIndex and the f32 fraction of the root visits
+
+using namespace boardgame;
+using namespace algorithm;
+
+using Options = std::map<std::string, std::string>;
+
+static const std::uint32_t kVersion = 1;
+static const std::array<char, 4> kFileMagic = { 'M', 'S', 'P', 'F' };
+static const std::array<char, 4> kChunkMagic = { 'M', 'S', 'P', 'C' };
+
+static std::string Option(Options const & options, std::string const & name, std::string const & fallback) {
+    auto found = options.find(name);
+    return found != options.end() ? found->second : fallback;
+}
+
+template<class StateType>
+struct Sample {
+    StateType state;
+
+    // {move index, fraction of the visits} of every root move
+    std::vector<std::pair<std::uint16_t, float>> policy;
+    std::int8_t result;
+};
+
+// the samples of one game, which only get their result once the game is over
+template<class StateType>
+using GameSamples = std::vector<Sample<StateType>>;
+
+// gathers samples into chunks and writes every full chunk
+template<class StateType>
+class ChunkWriter {
+public:
+    static_assert(std::is_trivially_copyable<StateType>::value, "states are stored as raw bytes");
+
+    ChunkWriter(std::string const & path, unsigned move_index_count, unsigned chunk_size)
+    : file_(path, std::ios::binary | std::ios::trunc), chunk_size_(std::max(1u, chunk_size)) {
+        std::vector<std::uint8_t> header(kFileMagic.begin(), kFileMagic.end());
+        record::WriteLittleEndian(header, kVersion);
+        record::WriteLittleEndian(header, static_cast<std::uint32_t>(sizeof(StateType)));
+        record::WriteLittleEndian(header, static_cast<std::uint32_t>(move_index_count));
+        Write(header);
+    }
+
+    ~ChunkWriter() {
+        Flush();
+    }
+
+    bool IsOpen() const {
+        return file_.is_open() && file_.good();
+    }
+
+    void Add(Sample<StateType> const & sample) {
+        auto const * bytes = reinterpret_cast<std::uint8_t const *>(&sample.state);
+        samples_.insert(samples_.end(), bytes, bytes + sizeof(StateType));
+        samples_.push_back(static_cast<std::uint8_t>(sample.result));
+        record::WriteLittleEndian(samples_, static_cast<std::uint16_t>(sample.policy.size()));
+        for (auto const & [move_index, fraction] : sample.policy) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &fraction, sizeof(bits));
+            record::WriteLittleEndian(samples_, move_index);
+            record::WriteLittleEndian(samples_, bits);
+        }
+
+        if (++sample_count_ == chunk_size_) Flush();
+    }
+
+    void Flush() {
+        if (sample_count_ == 0) return;
+
+        std::vector<std::uint8_t> header(kChunkMagic.begin(), kChunkMagic.end());
+        record::WriteLittleEndian(header, static_cast<std::uint32_t>(sample_count_));
+        record::WriteLittleEndian(header, static_cast<std::uint64_t>(samples_.size()));
+        Write(header);
+        Write(samples_);
+        file_.flush();
+
+        samples_.clear();
+        sample_count_ = 0;
+        chunk_count_ += 1;
+    }
+
+    unsigned long long ChunkCount() const {
+        return chunk_count_;
+    }
+
+private:
+    void Write(std::vector<std::uint8_t> const & bytes) {
+        file_.write(reinterpret_cast<char const *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    std::ofstream file_;
+    unsigned chunk_size_;
+    std::vector<std::uint8_t> samples_;
+    unsigned sample_count_ = 0;
+    unsigned long long chunk_count_ = 0;
+};
+
+template<class StateType>
+Sample<StateType> MakeSample(StateType const & state, std::vector<MoveAnalysis<StateType>> const & analysis) {
+    Sample<StateType> sample { state, {}, 0 };
+    double total_visits = 0.0;
+    for (auto const & move : analysis) {
+        total_visits += move.visits;
+    }
+    for (auto const & move : analysis) {
+        float fraction = total_visits > 0.0 ? static_cast<float>(move.visits / total_visits) : 1.0f / analysis.size();
+        sample.policy.emplace_back(static_cast<std::uint16_t>(move.move_index), fraction);
+    }
+    return sample;
+}
+
+// a root move drawn in proportion to its visits
+template<class StateType, class RandomEngineType>
+StateType SampleMove(std::vector<MoveAnalysis<StateType>> const & analysis, StateType const & fallback, RandomEngineType & random_engine) {
+    std::uint32_t total_visits = 0;
+    for (auto const & move : analysis) {
+        total_visits += move.visits;
+    }
+    if (total_visits == 0) return fallback;
+
+    std::uint32_t pick = utility::Bounded(random_engine, total_visits);
+    for (auto const & move : analysis) {
+        if (pick < move.visits) return move.state;
+        pick -= move.visits;
+    }
+    return fallback;
+}
+
+template<class GameType, class StateType, class MoveType>
+int RunSelfPlay(Options const & options) {
+    using Search = MonteCarloTreeSearch<GameType, StateType, 2>;
+
+    unsigned games = std::stoul(Option(options, "games", "100"));
+    unsigned search_threads = std::max(1u, static_cast<unsigned>(std::stoul(Option(options, "threads", "1"))));
+    unsigned iterations = std::stoul(Option(options, "iterations", "800"));
+    unsigned sample_plies = std::stoul(Option(options, "sample-plies", "8"));
+    unsigned max_plies = std::stoul(Option(options, "max-plies", "1000"));
+    unsigned chunk_size = std::stoul(Option(options, "chunk", "4096"));
+    unsigned queue_size = std::stoul(Option(options, "queue", "256"));
+    std::uint64_t seed = std::stoull(Option(options, "seed", std::to_string(utility::RandomSeed())));
+    std::string output = Option(options, "output", "self_play.bin");
+
+    unsigned concurrent_threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned concurrency = std::stoul(Option(options, "concurrency", "0"));
+    if (concurrency == 0) concurrency = std::max(1u, concurrent_threads / search_threads);
+    concurrency = std::min(concurrency, std::max(1u, games));
+
+    ChunkWriter<StateType> writer(output, GameType::kMoveIndexCount, chunk_size);
+    if (!writer.IsOpen()) {
+        std::cerr << "cannot write " << output << '\n';
+        return 1;
+    }
+
+    utility::BoundedQueue<GameSamples<StateType>> queue(queue_size);
+    std::atomic<unsigned> next_game(0);
+    std::atomic<unsigned> running_workers(concurrency);
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&](unsigned worker_index) {
+        std::uint64_t worker_seed = seed + worker_index;
+        Search search(iterations, std::numeric_limits<long long>::max(), 1.0, search_threads);
+        search.SetSeed(utility::SplitMix64(worker_seed));
+
+        // the policy targets need the visits of every move, not only of one move per group of symmetric moves,
+        // and the sampled openings should not only play the canonical ones
+        search.SetSymmetryPruning(false);
+        auto random_engine = utility::MakeRandomEngine<utility::Xoshiro256PlusPlus>(worker_seed, worker_index);
+
+        Simulation<GameType, StateType, MoveType, Search, Search> simulation(StateType(Player::kLeftPlayer), search, search);
+        for (unsigned game = next_game++; game < games; game = next_game++) {
+            simulation.Initialize(StateType(game % 2 == 0 ? Player::kLeftPlayer : Player::kRightPlayer));
+
+            GameSamples<StateType> samples;
+            std::tuple<bool, Player> winner = kOnGoingGame;
+            for (unsigned ply = 0; std::get<0>(winner) && ply < max_plies; ++ply) {
+                StateType state = simulation.State();
+                auto & side = state.player == Player::kLeftPlayer ? simulation.LeftAlgorithm() : simulation.RightAlgorithm();
+                StateType next_state = simulation.NextState(state);
+                auto analysis = side.LastAnalysis();
+
+                samples.push_back(MakeSample(state, analysis));
+                if (ply < sample_plies) next_state = SampleMove(analysis, next_state, random_engine);
+                winner = simulation.Play(next_state);
+            }
+
+            Player result = std::get<0>(winner) ? Player::kNone : std::get<1>(winner);
+            for (auto & sample : samples) {
+                sample.result = result == Player::kNone ? 0 : result == sample.state.player ? 1 : -1;
+            }
+            queue.Push(std::move(samples));
+        }
+        running_workers--;
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < concurrency; ++i) {
+        workers.emplace_back(worker, i);
+    }
+
+    // this thread writes, the queue is only known to be drained when it is empty after all workers ended
+    unsigned long long game_count = 0, sample_count = 0;
+    unsigned reported = 0;
+    for (;;) {
+        bool done = running_workers.load() == 0;
+        GameSamples<StateType> samples;
+        if (!queue.TryPop(samples)) {
+            if (done) break;
+            std::this_thread::yield();
+            continue;
+        }
+
+        for (auto const & sample : samples) {
+            writer.Add(sample);
+        }
+        game_count += 1;
+        sample_count += samples.size();
+
+        if (game_count * 10 / games > reported) {
+            reported = static_cast<unsigned>(game_count * 10 / games);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << game_count << " games, " << sample_count << " samples, " << sample_count / seconds << " samples/s\n";
+        }
+    }
+
+    for (auto & thread : workers) {
+        thread.join();
+    }
+    writer.Flush();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout
+        << "games: " << game_count << " (" << game_count / seconds << "/s)\n"
+        << "samples: " << sample_count << " (" << sample_count / seconds << "/s)\n"
+        << "chunks: " << writer.ChunkCount() << '\n'
+        << "concurrency: " << concurrency << " x " << search_threads << " threads\n"
+        << "seconds: " << seconds << '\n';
+    return 0;
+}
+
+int main(int argc, const char * argv[]) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key.compare(0, 2, "--") != 0) {
+            std::cerr << "expected an option instead of " << key << '\n';
+            return 1;
+        }
+        options[key.substr(2)] = argv[i + 1];
+    }
+
+    std::string game = Option(options, "game", "morris");
+    if (game == "tictactoe") return RunSelfPlay<TicTacToe, TicTacToeState, TicTacToeMove>(options);
+    if (game == "connect4") return RunSelfPlay<Connect4, Connect4State, Connect4Move>(options);
+    if (game == "connect5") return RunSelfPlay<Connect5, Connect5State, ConnectNMove>(options);
+    if (game == "morris6") return RunSelfPlay<SixMenMorris, SixMenMorrisState, MorrisMove>(options);
+    if (game == "morris") return RunSelfPlay<NineMenMorris, NineMenMorrisState, NineMenMorrisMove>(options);
+    if (game == "morris12") return RunSelfPlay<TwelveMenMorris, TwelveMenMorrisState, MorrisMove>(options);
+
+    std::cerr << "unknown game " << game << '\n';
+    return 1;
+}
@@ -187,6 +187,44 @@ struct napi_helper_finfo
         return value;
     }
 
+    // the elements of a typed array of the given type, written to in place
+    // throws a type error and returns null when the value is something else
+    template <typename T>
+    T * GetTypedArray(napi_value jValue, napi_typedarray_type type, size_t & length)
+    {
+        length = 0;
+
+        bool is_typedarray;
+        auto status = napi_is_typedarray(m_env, jValue, &is_typedarray);
+        assert(status == napi_ok);
+
+        napi_typedarray_type value_type;
+        size_t value_length;
+        void * data = nullptr;
+        if (is_typedarray)
+        {
+            napi_value array_buffer;
+            size_t byte_offset;
+            status = napi_get_typedarray_info(m_env, jValue, &value_type, &value_length, &data, &array_buffer, &byte_offset);
+            assert(status == napi_ok);
+        }
+
+        if (!is_typedarray || value_type != type)
+        {
+            napi_throw_type_error(m_env, nullptr, "unexpected typed array type");
+            return nullptr;
+        }
+
+        length = value_length;
+        return static_cast<T *>(data);
+    }
+
+    template <typename T>
+    T * GetTypedArray(int i, napi_typedarray_type type, size_t & length)
+    {
+        return GetTypedArray<T>(m_argv[i], type, length);
+    }
+
     napi_value Return(int value)
     {
         napi_value jsValue;
@@ -2,9 +2,152 @@
 
 napi_ref Simulation::constructor;
 
+using Analysis = algorithm::MonteCarloTreeSearch<boardgame::NineMenMorris, boardgame::NineMenMorrisState, 2>::Analysis;
+
+struct MoveWork
+{
+    MoveWork(Simulation * simulation, boardgame::NineMenMorrisState const & state, size_t total_moves) :
+        simulation(simulation), state(state), next_state(state), total_moves(total_moves),
+        stop(std::make_shared<std::atomic<bool>>(false)) {}
+
+    napi_async_work work = nullptr;
+    napi_deferred deferred = nullptr;
+
+    // keeps the javascript object, and with it the simulation, alive until the search is done
+    napi_ref simulation_ref = nullptr;
+    Simulation * simulation;
+
+    boardgame::NineMenMorrisState state;
+    boardgame::NineMenMorrisState next_state;
+
+    // the game must still be where the search started when the result comes back
+    size_t total_moves;
+
+    // stop ends the search early and plays its best move, a cancelled move is thrown away
+    std::shared_ptr<std::atomic<bool>> stop;
+    bool cancelled = false;
+
+    // passes the analysis snapshots from the search thread to the javascript callback
+    napi_threadsafe_function analysis_function = nullptr;
+};
+
+static void RejectMove(napi_env env, napi_deferred deferred, std::string const & message)
+{
+    napi_value j_message, j_error;
+    auto status = napi_create_string_utf8(env, message.c_str(), message.length(), &j_message);
+    assert(status == napi_ok);
+    status = napi_create_error(env, nullptr, j_message, &j_error);
+    assert(status == napi_ok);
+    status = napi_reject_deferred(env, deferred, j_error);
+    assert(status == napi_ok);
+}
+
+// runs on the main thread for every analysis snapshot the search posted
+static void CallAnalysis(napi_env env, napi_value js_callback, void * /*context*/, void * data)
+{
+    auto * analysis = static_cast<Analysis *>(data);
+
+    // env is null while the function is torn down, the snapshot is only freed then
+    if (env != nullptr && js_callback != nullptr)
+    {
+        auto number = [env](double value) {
+            napi_value j_value;
+            auto status = napi_create_double(env, value, &j_value);
+            assert(status == napi_ok);
+            return j_value;
+        };
+        auto set = [env](napi_value object, char const * name, napi_value value) {
+            auto status = napi_set_named_property(env, object, name, value);
+            assert(status == napi_ok);
+        };
+
+        napi_value j_analysis;
+        auto status = napi_create_array_with_length(env, analysis->size(), &j_analysis);
+        assert(status == napi_ok);
+        for (unsigned i = 0; i < analysis->size(); ++i)
+        {
+            auto const & move = (*analysis)[i];
+
+            // move indices are (source + 1) * 24 + destination
+            napi_value j_move;
+            status = napi_create_object(env, &j_move);
+            assert(status == napi_ok);
+            set(j_move, "source", number(static_cast<int>(move.move_index / boardgame::NineMenMorrisState::kBoardSize) - 1));
+            set(j_move, "destination", number(move.move_index % boardgame::NineMenMorrisState::kBoardSize));
+            set(j_move, "visits", number(move.visits));
+            set(j_move, "value", number(move.value));
+
+            napi_value j_variation;
+            status = napi_create_array_with_length(env, move.principal_variation.size(), &j_variation);
+            assert(status == napi_ok);
+            for (unsigned j = 0; j < move.principal_variation.size(); ++j)
+            {
+                status = napi_set_element(env, j_variation, j, number(move.principal_variation[j]));
+                assert(status == napi_ok);
+            }
+            set(j_move, "principal_variation", j_variation);
+
+            status = napi_set_element(env, j_analysis, i, j_move);
+            assert(status == napi_ok);
+        }
+
+        napi_value j_undefined;
+        status = napi_get_undefined(env, &j_undefined);
+        assert(status == napi_ok);
+        napi_call_function(env, j_undefined, js_callback, 1, &j_analysis, nullptr);
+    }
+
+    delete analysis;
+}
+
+// the typed array exports write a state as kStateSize int8 values:
+// 24 cells (-1 empty, 0 left player, 1 right player), the player to move,
+// the pieces each player still has to place, the pieces each player has left
+// and the stage of the player to move
+static const unsigned kStateSize = boardgame::NineMenMorrisState::kBoardSize + 6;
+
+static void WriteState(boardgame::NineMenMorrisState const & state, int8_t * out)
+{
+    using boardgame::Player;
+
+    for (unsigned i = 0; i < state.board.size(); ++i)
+    {
+        *out++ = state.board[i] == Player::kNone ? -1 : static_cast<int8_t>(state.board[i]);
+    }
+    *out++ = static_cast<int8_t>(state.player);
+    *out++ = static_cast<int8_t>(state.RemainingToPlay(Player::kLeftPlayer));
+    *out++ = static_cast<int8_t>(state.RemainingToPlay(Player::kRightPlayer));
+    *out++ = static_cast<int8_t>(state.Remaining(Player::kLeftPlayer));
+    *out++ = static_cast<int8_t>(state.Remaining(Player::kRightPlayer));
+    *out++ = static_cast<int8_t>(state.Stage(state.player));
+}
+
+// a move is packed into one int32 as (source + 1) | (destination + 1) << 8 | (deletion + 1) << 16
+static int32_t PackMove(boardgame::NineMenMorrisMove const & move)
+{
+    return (move.source + 1) | (move.destination + 1) << 8 | (move.deletion + 1) << 16;
+}
+
+// writes as many moves as fit and returns how many there are, so the caller can grow its buffer
+template <class C>
+static napi_value WriteMoves(napi_helper_finfo<C> & finfo, std::vector<boardgame::NineMenMorrisMove> const & moves)
+{
+    size_t length;
+    auto * out = finfo.template GetTypedArray<int32_t>(0, napi_int32_array, length);
+    if (out == nullptr) return finfo.Undefined();
+
+    for (size_t i = 0; i < moves.size() && i < length; ++i)
+    {
+        out[i] = PackMove(moves[i]);
+    }
+    return finfo.Return(static_cast<unsigned>(moves.size()));
+}
+
 Simulation::Simulation() :
     m_env(nullptr),
-    m_wrapper(nullptr)
+    m_wrapper(nullptr),
+    move_work_(nullptr),
+    searched_last_move_(false)
 {
     auto initial_state = []() { return boardgame::NineMenMorrisState(boardgame::Player::kRightPlayer); };
 
@@ -30,10 +173,18 @@ napi_value Simulation::Init(napi_env env, napi_value exports)
 {
     std::vector<napi_property_descriptor> properties = {
         NAPI_METHOD_DESCRIPTOR(Move),
+        NAPI_METHOD_DESCRIPTOR(MoveAsync),
+        NAPI_METHOD_DESCRIPTOR(Stop),
+        NAPI_METHOD_DESCRIPTOR(Cancel),
         NAPI_METHOD_DESCRIPTOR(MoveHuman),
         NAPI_METHOD_DESCRIPTOR(State),
         NAPI_METHOD_DESCRIPTOR(ListMoves),
-        NAPI_METHOD_DESCRIPTOR(PlacementMoves)
+        NAPI_METHOD_DESCRIPTOR(PlacementMoves),
+        NAPI_METHOD_DESCRIPTOR(StateInto),
+        NAPI_METHOD_DESCRIPTOR(ListMovesInto),
+        NAPI_METHOD_DESCRIPTOR(PlacementMovesInto),
+        NAPI_METHOD_DESCRIPTOR(HistoryInto),
+        NAPI_METHOD_DESCRIPTOR(Statistics)
     };
 
     return napi_helper::Init(env, exports, Simulation::constructor, Simulation::New, "Simulation", properties);
@@ -53,11 +204,171 @@ napi_value Simulation::Move(napi_env env, napi_callback_info info)
 {
     napi_helper_finfo<Simulation> finfo(env, info);
 
+    // the search of a MoveAsync must not run twice at once
+    if (finfo.This()->move_work_ != nullptr)
+    {
+        napi_throw_error(env, nullptr, "a move is being computed");
+        return finfo.Undefined();
+    }
+
     auto result = finfo.This()->simulation_->Move();
+    finfo.This()->searched_last_move_ = true;
 
     return finfo.Return(std::get<0>(result));
 }
 
+// searches on the libuv thread pool and resolves to whether the game is still going
+// rejects when cancelled or when the game moved on while searching
+// MoveAsync(onAnalysis, intervalInMilliseconds, topCount) calls onAnalysis with the top moves while searching
+napi_value Simulation::MoveAsync(napi_env env, napi_callback_info info)
+{
+    napi_helper_finfo<Simulation> finfo(env, info, 3);
+    auto * self = finfo.This();
+
+    napi_value promise;
+    napi_deferred deferred;
+    auto status = napi_create_promise(env, &deferred, &promise);
+    assert(status == napi_ok);
+
+    if (self->move_work_ != nullptr)
+    {
+        RejectMove(env, deferred, "a move is already being computed");
+        return promise;
+    }
+
+    auto * work = new MoveWork(self, self->simulation_->State(), self->simulation_->TotalMoves());
+    work->deferred = deferred;
+    self->simulation_->LeftAlgorithm().SetStopToken(work->stop);
+    self->simulation_->RightAlgorithm().SetStopToken(work->stop);
+
+    napi_valuetype analysis_type = napi_undefined;
+    if (finfo.Count() > 0)
+    {
+        status = napi_typeof(env, finfo.GetValue(0), &analysis_type);
+        assert(status == napi_ok);
+    }
+    if (analysis_type == napi_function)
+    {
+        long long interval = finfo.Count() > 1 ? finfo.GetInt64(1) : 250;
+        unsigned top_count = finfo.Count() > 2 ? finfo.GetUInt(2) : 5;
+
+        napi_value name;
+        status = napi_create_string_utf8(env, "MoveAsyncAnalysis", NAPI_AUTO_LENGTH, &name);
+        assert(status == napi_ok);
+        status = napi_create_threadsafe_function(env, finfo.GetValue(0), nullptr, name, 0, 1,
+                                                 nullptr, nullptr, nullptr, CallAnalysis, &work->analysis_function);
+        assert(status == napi_ok);
+
+        auto analysis_function = work->analysis_function;
+        auto stop = work->stop;
+        auto callback = [analysis_function, stop](Analysis const & analysis) {
+            auto * data = new Analysis(analysis);
+            if (napi_call_threadsafe_function(analysis_function, data, napi_tsfn_nonblocking) != napi_ok)
+            {
+                delete data;
+            }
+            return !stop->load();
+        };
+        self->simulation_->LeftAlgorithm().SetAnalysisCallback(callback, interval, top_count);
+        self->simulation_->RightAlgorithm().SetAnalysisCallback(callback, interval, top_count);
+    }
+
+    status = napi_create_reference(env, finfo.JSThis(), 1, &work->simulation_ref);
+    assert(status == napi_ok);
+
+    napi_value name;
+    status = napi_create_string_utf8(env, "MoveAsync", NAPI_AUTO_LENGTH, &name);
+    assert(status == napi_ok);
+    status = napi_create_async_work(env, nullptr, name, ExecuteMove, CompleteMove, work, &work->work);
+    assert(status == napi_ok);
+    status = napi_queue_async_work(env, work->work);
+    assert(status == napi_ok);
+
+    self->move_work_ = work;
+    return promise;
+}
+
+// runs on a worker thread, so no javascript values can be touched here
+void Simulation::ExecuteMove(napi_env /*env*/, void * data)
+{
+    auto * work = static_cast<MoveWork *>(data);
+    work->next_state = work->simulation->simulation_->NextState(work->state);
+}
+
+void Simulation::CompleteMove(napi_env env, napi_status status, void * data)
+{
+    auto * work = static_cast<MoveWork *>(data);
+    auto * self = work->simulation;
+    self->move_work_ = nullptr;
+
+    // a stopped token would end every later search right away
+    self->simulation_->LeftAlgorithm().SetStopToken(nullptr);
+    self->simulation_->RightAlgorithm().SetStopToken(nullptr);
+
+    if (work->analysis_function != nullptr)
+    {
+        self->simulation_->LeftAlgorithm().SetAnalysisCallback(nullptr);
+        self->simulation_->RightAlgorithm().SetAnalysisCallback(nullptr);
+        napi_release_threadsafe_function(work->analysis_function, napi_tsfn_release);
+    }
+
+    if (status == napi_cancelled || work->cancelled)
+    {
+        RejectMove(env, work->deferred, "cancelled");
+    }
+    else if (self->simulation_->TotalMoves() != work->total_moves)
+    {
+        RejectMove(env, work->deferred, "the game changed while computing the move");
+    }
+    else
+    {
+        auto result = self->simulation_->Play(work->next_state);
+        self->searched_last_move_ = true;
+
+        napi_value j_on_going;
+        auto result_status = napi_get_boolean(env, std::get<0>(result), &j_on_going);
+        assert(result_status == napi_ok);
+        result_status = napi_resolve_deferred(env, work->deferred, j_on_going);
+        assert(result_status == napi_ok);
+    }
+
+    napi_delete_async_work(env, work->work);
+    napi_delete_reference(env, work->simulation_ref);
+    delete work;
+}
+
+// ends the search of MoveAsync early, for example once the analysis settled, and plays its best move
+napi_value Simulation::Stop(napi_env env, napi_callback_info info)
+{
+    napi_helper_finfo<Simulation> finfo(env, info);
+    auto * work = finfo.This()->move_work_;
+
+    if (work != nullptr)
+    {
+        work->stop->store(true);
+    }
+
+    return finfo.Undefined();
+}
+
+// stops the search of MoveAsync, its promise is rejected
+napi_value Simulation::Cancel(napi_env env, napi_callback_info info)
+{
+    napi_helper_finfo<Simulation> finfo(env, info);
+    auto * work = finfo.This()->move_work_;
+
+    if (work != nullptr)
+    {
+        work->cancelled = true;
+        work->stop->store(true);
+
+        // succeeds only when the search has not started yet
+        napi_cancel_async_work(env, work->work);
+    }
+
+    return finfo.Undefined();
+}
+
 napi_value Simulation::PlacementMoves(napi_env env, napi_callback_info info)
 {
     napi_helper_finfo<Simulation> finfo(env, info);
@@ -110,6 +421,7 @@ napi_value Simulation::MoveHuman(napi_env env, napi_callback_info info)
     auto move = boardgame::NineMenMorrisMove(source, destination, deletion);
 
     auto result = finfo.This()->simulation_->Move(move);
+    finfo.This()->searched_last_move_ = false;
 
     return finfo.Return(std::get<0>(result));
 }
@@ -149,4 +461,98 @@ napi_value Simulation::State(napi_env env, napi_callback_info info)
     finfo.SetProperty(j_object, "stage", finfo.Return(static_cast<int>(stage)));
 
     return j_object;
-}
\ No newline at end of file
+}
+
+napi_value Simulation::Statistics(napi_env env, napi_callback_info info)
+{
+    napi_helper_finfo<Simulation> finfo(env, info);
+
+    // the running search of a MoveAsync writes them
+    if (finfo.This()->move_work_ != nullptr)
+    {
+        napi_throw_error(env, nullptr, "a move is being computed");
+        return finfo.Undefined();
+    }
+
+    // undefined when a human played the last move, the search of that side is from an earlier one
+    if (!finfo.This()->searched_last_move_)
+    {
+        return finfo.Undefined();
+    }
+
+    // the statistics of the search that played the last move
+    auto * simulation = finfo.This()->simulation_;
+    auto const & statistics = boardgame::Opponent(simulation->State().player) == boardgame::Player::kLeftPlayer ?
+        simulation->LeftAlgorithm().Statistics() : simulation->RightAlgorithm().Statistics();
+
+    auto j_object = finfo.CreateObject();
+    finfo.SetProperty(j_object, "iterations", finfo.Return(static_cast<double>(statistics.iterations)));
+    finfo.SetProperty(j_object, "nodes", finfo.Return(static_cast<double>(statistics.nodes)));
+    finfo.SetProperty(j_object, "pruned_nodes", finfo.Return(static_cast<double>(statistics.pruned_nodes)));
+    finfo.SetProperty(j_object, "nodes_per_second", finfo.Return(statistics.NodesPerSecond()));
+    finfo.SetProperty(j_object, "max_depth", finfo.Return(statistics.max_depth));
+    finfo.SetProperty(j_object, "average_rollout_length", finfo.Return(statistics.average_rollout_length));
+    finfo.SetProperty(j_object, "thread_iterations_per_second", finfo.Return(statistics.thread_iterations_per_second));
+    finfo.SetProperty(j_object, "select_seconds", finfo.Return(statistics.select_seconds));
+    finfo.SetProperty(j_object, "expand_seconds", finfo.Return(statistics.expand_seconds));
+    finfo.SetProperty(j_object, "simulate_seconds", finfo.Return(statistics.simulate_seconds));
+    finfo.SetProperty(j_object, "backup_seconds", finfo.Return(statistics.backup_seconds));
+    finfo.SetProperty(j_object, "seconds", finfo.Return(statistics.seconds));
+    finfo.SetProperty(j_object, "peak_memory_bytes", finfo.Return(static_cast<double>(statistics.peak_memory_bytes)));
+    finfo.SetProperty(j_object, "stop_reason", finfo.Return(algorithm::StopReasonName(statistics.stop_reason)));
+
+    return j_object;
+}
+
+// StateInto(Int8Array) writes the current state, see kStateSize
+napi_value Simulation::StateInto(napi_env env, napi_callback_info info)
+{
+    napi_helper_finfo<Simulation> finfo(env, info, 1);
+
+    size_t length;
+    auto * out = finfo.GetTypedArray<int8_t>(0, napi_int8_array, length);
+    if (out == nullptr) return finfo.Undefined();
+    if (length < kStateSize)
+    {
+        napi_throw_range_error(env, nullptr, "the state needs a larger array");
+        return finfo.Undefined();
+    }
+
+    WriteState(finfo.This()->simulation_->State(), out);
+    return finfo.Return(kStateSize);
+}
+
+// ListMovesInto(Int32Array) packs the legal moves, see PackMove, and returns their count
+napi_value Simulation::ListMovesInto(napi_env env, napi_callback_info info)
+{
+    napi_helper_finfo<Simulation> finfo(env, info, 1);
+
+    auto state = finfo.This()->simulation_->State();
+    return WriteMoves(finfo, boardgame::NineMenMorris::ListMoves(state));
+}
+
+napi_value Simulation::PlacementMovesInto(napi_env env, napi_callback_info info)
+{
+    napi_helper_finfo<Simulation> finfo(env, info, 1);
+
+    auto state = finfo.This()->simulation_->State();
+    return WriteMoves(finfo, boardgame::NineMenMorris::PlacementMoves(state));
+}
+
+// HistoryInto(Int8Array) writes every state of the game back to back, kStateSize values each
+// writes as many states as fit and returns how many there are
+napi_value Simulation::HistoryInto(napi_env env, napi_callback_info info)
+{
+    napi_helper_finfo<Simulation> finfo(env, info, 1);
+
+    size_t length;
+    auto * out = finfo.GetTypedArray<int8_t>(0, napi_int8_array, length);
+    if (out == nullptr) return finfo.Undefined();
+
+    auto const & history = finfo.This()->simulation_->History();
+    for (size_t i = 0; i < history.size() && (i + 1) * kStateSize <= length; ++i)
+    {
+        WriteState(history[i], out + i * kStateSize);
+    }
+    return finfo.Return(static_cast<unsigned>(history.size()));
+}
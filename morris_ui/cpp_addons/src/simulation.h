@@ -7,21 +7,35 @@
 #include "morris/algorithms/random_play.hpp"
 #include "morris/algorithms/mcts.hpp"
 
+// a search running on the libuv thread pool for MoveAsync
+struct MoveWork;
+
 class Simulation
 {
 public:
     static napi_value Init(napi_env env, napi_value exports);
     static napi_value New(napi_env env, napi_callback_info info);
     static napi_value Move(napi_env env, napi_callback_info info);
+    static napi_value MoveAsync(napi_env env, napi_callback_info info);
+    static napi_value Stop(napi_env env, napi_callback_info info);
+    static napi_value Cancel(napi_env env, napi_callback_info info);
     static napi_value MoveHuman(napi_env env, napi_callback_info info);
     static napi_value State(napi_env env, napi_callback_info info);
     static napi_value ListMoves(napi_env env, napi_callback_info info);
     static napi_value PlacementMoves(napi_env env, napi_callback_info info);
+    static napi_value StateInto(napi_env env, napi_callback_info info);
+    static napi_value ListMovesInto(napi_env env, napi_callback_info info);
+    static napi_value PlacementMovesInto(napi_env env, napi_callback_info info);
+    static napi_value HistoryInto(napi_env env, napi_callback_info info);
+    static napi_value Statistics(napi_env env, napi_callback_info info);
 
 private:
     explicit Simulation();
     ~Simulation();
 
+    static void ExecuteMove(napi_env env, void * data);
+    static void CompleteMove(napi_env env, napi_status status, void * data);
+
 private:
     static napi_ref constructor;
     napi_env m_env;
@@ -34,5 +48,11 @@ private:
                         algorithm::MonteCarloTreeSearch<boardgame::NineMenMorris, boardgame::NineMenMorrisState, 2>,
                         algorithm::MonteCarloTreeSearch<boardgame::NineMenMorris, boardgame::NineMenMorrisState, 2> > * simulation_;
 
+    // the MoveAsync in flight, at most one at a time
+    MoveWork * move_work_;
+
+    // whether a search played the last move, Statistics has nothing for a human move
+    bool searched_last_move_;
+
     friend class napi_helper;
 };
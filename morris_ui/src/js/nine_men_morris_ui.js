@@ -20,7 +20,8 @@ export default class NineMenMorrisUI extends Component {
       right_player_ai_name: 'Human',
       moves: [],
       placement_moves: [],
-      deletion_moves: []
+      deletion_moves: [],
+      analysis: []
     };
 
     this.left_player = 'left_player';
@@ -44,21 +45,37 @@ export default class NineMenMorrisUI extends Component {
 
   initialize() {
     this.simulation = addon.Simulation();
-    this.setState({ on_going: true, moves: [], placement_moves: [], deletion_moves: [] });
+    this.setState({ on_going: true, moves: [], placement_moves: [], deletion_moves: [], analysis: [] });
     this.setGameState();
   }
 
   reset() {
+    // a search that is still running is stopped and its move thrown away
+    this.simulation.Cancel();
+    this.thinking = false;
     this.initialize();
   }
 
   step() {
-    if (!this.state.on_going || this.getCurrentPlayerAI() == "Human") return;
+    if (!this.state.on_going || this.getCurrentPlayerAI() == "Human" || this.thinking) return;
 
-    let on_going = this.simulation.Move();
-    this.setState({ on_going: on_going });
-
-    this.setGameState();
+    // the search runs off the main thread, so the ui stays responsive while the ai thinks
+    let simulation = this.simulation;
+    this.thinking = true;
+    let onAnalysis = analysis => {
+      if (simulation === this.simulation) this.setState({ analysis: analysis });
+    };
+    simulation.MoveAsync(onAnalysis, 250, 3)
+      .then(on_going => {
+        if (simulation !== this.simulation) return;
+        this.thinking = false;
+        this.setState({ on_going: on_going });
+        this.setGameState();
+      })
+      .catch(error => {
+        if (simulation === this.simulation) this.thinking = false;
+        console.log(error.message);
+      });
   }
 
   setGameState() {
@@ -464,6 +481,13 @@ export default class NineMenMorrisUI extends Component {
             Reset
           </button>
         </div>
+        <div className="row">
+          {this.state.analysis.map((move, i) =>
+            <div key={i}>
+              {move.source} &rarr; {move.destination}: {move.visits} visits, value {move.value.toFixed(3)}&nbsp;
+            </div>
+          )}
+        </div>
       </div>
     );
   }